@@ -0,0 +1,59 @@
+/**
+ * @brief Microbenchmark: mutex barrier vs. spin-then-block barrier.
+ *
+ * For each thread count, every thread crosses the barrier ROUNDS times and
+ * the mean time per crossing is printed for both variants.
+ *
+ * Usage: barrier_bench [maxThreads] [rounds] [spinLimit]
+ */
+
+#include "Barrier.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#define DEFAULT_ROUNDS 20000
+#define DEFAULT_SPIN_LIMIT 4096
+
+/**
+ * @brief Returns nanoseconds per barrier crossing with threadCount threads.
+ */
+static double timeBarrier(int threadCount, int rounds, unsigned spinLimit) {
+    Barrier barrier(threadCount, spinLimit);
+    auto body = [&barrier, rounds]() {
+        for (int i = 0; i < rounds; ++i) {
+            barrier.barrier();
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(body);
+    }
+    body();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+}
+
+int main(int argc, char** argv) {
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : (hardware > 0 ? hardware : 4);
+    int rounds = argc > 2 ? std::atoi(argv[2]) : DEFAULT_ROUNDS;
+    unsigned spinLimit = argc > 3 ? std::atoi(argv[3]) : DEFAULT_SPIN_LIMIT;
+
+    std::cout << "threads,mutex_ns,spin_ns\n";
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        double blocking = timeBarrier(threads, rounds, 0);
+        double spinning = timeBarrier(threads, rounds, spinLimit);
+        std::cout << threads << ',' << std::fixed << std::setprecision(1)
+                  << blocking << ',' << spinning << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,286 @@
+/**
+ * @brief Synthetic MapReduce benchmark sweeping scale, skew, cost and threads.
+ *
+ * Every combination of the swept parameters runs as one job (repeated and
+ * reported per repetition) and prints one CSV row or JSON object with the
+ * throughput and the per-phase times from JobStats. Phase columns are the
+ * slowest thread's time in that phase, in milliseconds.
+ *
+ * Usage: job_bench [--sizes N,...] [--keys K,...] [--skew S,...] [--cost C,...]
+ *                  [--threads T,...] [--modes serial|parallel|hash,...]
+ *                  [--repeat R] [--format csv|json]
+ *
+ * --keys sets unique_keys, the key cardinality used by the tests; --skew is
+ * the Zipf exponent of the key distribution (0 = uniform); --cost is the
+ * number of busy-loop iterations per map call and per reduced pair. --help
+ * prints the usage and exits.
+ */
+
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define DEFAULT_REPEAT 3
+
+unsigned int unique_keys = 100;
+static unsigned int workCost = 0;
+
+// ======================[ Workload Types ]==========================
+
+class BenchInput : public K1 {
+public:
+    explicit BenchInput(int key) : key(key) {}
+    bool operator<(const K1& other) const override {
+        return key < static_cast<const BenchInput&>(other).key;
+    }
+    int key;                               // Pre-drawn intermediate key
+};
+
+class BenchKey : public K2, public K3 {
+public:
+    explicit BenchKey(int key) : key(key) {}
+    bool operator<(const K2& other) const override {
+        return key < static_cast<const BenchKey&>(other).key;
+    }
+    bool operator<(const K3& other) const override {
+        return key < static_cast<const BenchKey&>(other).key;
+    }
+    bool sortPrefix(uint64_t* prefix) const override {
+        *prefix = integerSortPrefix(key);
+        return true;
+    }
+    int key;
+};
+
+class BenchCount : public V2, public V3 {
+public:
+    explicit BenchCount(long count) : count(count) {}
+    long count;
+};
+
+/**
+ * @brief Burns roughly cost iterations of dependent arithmetic.
+ */
+static long spin(unsigned int cost, long seed) {
+    volatile long value = seed;
+    for (unsigned int i = 0; i < cost; ++i) {
+        value = value * 6364136223846793005L + 1442695040888963407L;
+    }
+    return value;
+}
+
+class BenchClient : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* /*value*/, void* context) const override {
+        int k = static_cast<const BenchInput*>(key)->key;
+        spin(workCost, k);
+        emit2(newIntermediate<BenchKey>(context, k), newIntermediate<BenchCount>(context, 1), context);
+    }
+
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        long total = 0;
+        for (const IntermediatePair& pair : *pairs) {
+            total += static_cast<const BenchCount*>(pair.second)->count;
+            spin(workCost, total);
+        }
+        int key = static_cast<const BenchKey*>(pairs->front().first)->key;
+        emit3(new BenchKey(key), new BenchCount(total), context);
+    }
+};
+
+static size_t hashKey(const K2* key) {
+    return std::hash<int>()(static_cast<const BenchKey*>(key)->key);
+}
+
+// ======================[ Helper Functions ]========================
+
+template <typename T>
+static std::vector<T> parseList(const char* text) {
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        std::stringstream field(item);
+        T value;
+        field >> value;
+        values.push_back(value);
+    }
+    return values;
+}
+
+/**
+ * @brief Draws size keys in [0, keys) with Zipf exponent skew.
+ */
+static std::vector<int> drawKeys(size_t size, unsigned int keys, double skew, unsigned seed) {
+    std::vector<double> cdf(keys);
+    double sum = 0;
+    for (unsigned int k = 0; k < keys; ++k) {
+        sum += 1.0 / std::pow(k + 1.0, skew);
+        cdf[k] = sum;
+    }
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    std::vector<int> drawn(size);
+    for (size_t i = 0; i < size; ++i) {
+        drawn[i] = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin());
+        if (drawn[i] >= static_cast<int>(keys)) drawn[i] = keys - 1;
+    }
+    // Scatter the hot keys so rank does not match key order
+    std::vector<int> relabel(keys);
+    for (unsigned int k = 0; k < keys; ++k) relabel[k] = k;
+    std::shuffle(relabel.begin(), relabel.end(), rng);
+    for (int& key : drawn) key = relabel[key];
+    return drawn;
+}
+
+static shuffle_mode_t parseMode(const std::string& name) {
+    if (name == "parallel") return SHUFFLE_PARALLEL;
+    if (name == "hash") return SHUFFLE_HASH;
+    return SHUFFLE_SERIAL;
+}
+
+static void printUsage(std::ostream& out) {
+    out << "Usage: job_bench [--sizes N,...] [--keys K,...] [--skew S,...] [--cost C,...]\n"
+           "                 [--threads T,...] [--modes serial|parallel|hash,...]\n"
+           "                 [--repeat R] [--format csv|json]\n";
+}
+
+// ======================[ Main ]====================================
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes = {100000, 1000000};
+    std::vector<unsigned int> keyCounts = {100, 100000};
+    std::vector<double> skews = {0.0, 1.0};
+    std::vector<unsigned int> costs = {0, 200};
+    std::vector<int> threadCounts = {1, 2, 4};
+    std::vector<std::string> modes = {"serial", "parallel"};
+    int repeat = DEFAULT_REPEAT;
+    bool json = false;
+
+    for (int i = 1; i < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--help" || flag == "-h") {
+            printUsage(std::cout);
+            return 0;
+        }
+        if (i + 1 == argc) {
+            std::cerr << "missing value for " << flag << std::endl;
+            printUsage(std::cerr);
+            return 1;
+        }
+        if (flag == "--sizes") sizes = parseList<size_t>(argv[i + 1]);
+        else if (flag == "--keys") keyCounts = parseList<unsigned int>(argv[i + 1]);
+        else if (flag == "--skew") skews = parseList<double>(argv[i + 1]);
+        else if (flag == "--cost") costs = parseList<unsigned int>(argv[i + 1]);
+        else if (flag == "--threads") threadCounts = parseList<int>(argv[i + 1]);
+        else if (flag == "--modes") modes = parseList<std::string>(argv[i + 1]);
+        else if (flag == "--repeat") repeat = std::atoi(argv[i + 1]);
+        else if (flag == "--format") json = std::strcmp(argv[i + 1], "json") == 0;
+        else {
+            std::cerr << "unknown option " << flag << std::endl;
+            printUsage(std::cerr);
+            return 1;
+        }
+    }
+
+    if (json) {
+        std::cout << "[\n";
+    } else {
+        std::cout << "size,keys,skew,cost,threads,mode,run,seconds,records_per_sec";
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            std::cout << ',' << phaseName(static_cast<job_phase_t>(p)) << "_ms";
+        }
+        std::cout << '\n';
+    }
+
+    BenchClient client;
+    bool firstRow = true;
+    for (size_t size : sizes) {
+        for (unsigned int keys : keyCounts) {
+            unique_keys = keys;
+            for (double skew : skews) {
+                std::vector<int> drawn = drawKeys(size, keys, skew, 0);
+                InputVec inputVec;
+                inputVec.reserve(size);
+                for (int key : drawn) {
+                    inputVec.push_back({ new BenchInput(key), nullptr });
+                }
+
+                for (unsigned int cost : costs) {
+                    workCost = cost;
+                    for (int threads : threadCounts) {
+                        for (const std::string& mode : modes) {
+                            for (int run = 0; run < repeat; ++run) {
+                                JobOptions options;
+                                options.shuffleMode = parseMode(mode);
+                                options.keyHash = hashKey;
+                                options.collectStats = true;
+
+                                OutputVec outputVec;
+                                auto start = std::chrono::steady_clock::now();
+                                JobHandle job = startMapReduceJob(client, inputVec, outputVec,
+                                                                  threads, options);
+                                waitForJob(job);
+                                double seconds = std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() - start).count();
+                                JobStats stats;
+                                getJobStats(job, &stats);
+                                closeJobHandle(job);
+                                for (OutputPair& pair : outputVec) {
+                                    delete pair.first;
+                                    delete pair.second;
+                                }
+
+                                double phaseMs[PHASE_COUNT] = {0};
+                                for (const ThreadStats& thread : stats.threads) {
+                                    for (int p = 0; p < PHASE_COUNT; ++p) {
+                                        phaseMs[p] = std::max(phaseMs[p], thread.wallNanos[p] / 1e6);
+                                    }
+                                }
+
+                                if (json) {
+                                    std::cout << (firstRow ? "" : ",\n")
+                                              << "  {\"size\":" << size << ",\"keys\":" << keys
+                                              << ",\"skew\":" << skew << ",\"cost\":" << cost
+                                              << ",\"threads\":" << threads << ",\"mode\":\"" << mode
+                                              << "\",\"run\":" << run << ",\"seconds\":" << seconds
+                                              << ",\"records_per_sec\":" << size / seconds;
+                                    for (int p = 0; p < PHASE_COUNT; ++p) {
+                                        std::cout << ",\"" << phaseName(static_cast<job_phase_t>(p))
+                                                  << "_ms\":" << phaseMs[p];
+                                    }
+                                    std::cout << '}';
+                                } else {
+                                    std::cout << size << ',' << keys << ',' << skew << ',' << cost
+                                              << ',' << threads << ',' << mode << ',' << run << ','
+                                              << seconds << ',' << size / seconds;
+                                    for (int p = 0; p < PHASE_COUNT; ++p) {
+                                        std::cout << ',' << phaseMs[p];
+                                    }
+                                    std::cout << '\n';
+                                }
+                                std::cout.flush();
+                                firstRow = false;
+                            }
+                        }
+                    }
+                }
+                for (InputPair& pair : inputVec) {
+                    delete pair.first;
+                }
+            }
+        }
+    }
+    if (json) {
+        std::cout << "\n]\n";
+    }
+    return 0;
+}
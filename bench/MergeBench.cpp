@@ -0,0 +1,148 @@
+/**
+ * @brief Microbenchmark: binary-heap vs. loser-tree k-way merge of sorted runs.
+ *
+ * For each run count k, the same sorted runs of pointer pairs are merged
+ * into key groups with the std::priority_queue merge the shuffle used before
+ * and with LoserTree, and the time and K2 comparisons per pair are printed.
+ *
+ * Usage: merge_bench [pairs] [maxRuns] [keys]
+ */
+
+#include "MapReduceClient.h"
+#include "LoserTree.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#define DEFAULT_PAIRS (1 << 20)
+#define DEFAULT_MAX_RUNS 128
+#define DEFAULT_KEYS (1 << 17)
+#define MIN_RUNS 4
+
+static uint64_t comparisons = 0;
+
+class BenchKey : public K2 {
+public:
+    explicit BenchKey(int num) : num(num) {}
+    bool operator<(const K2& other) const override {
+        ++comparisons;
+        return num < static_cast<const BenchKey&>(other).num;
+    }
+    int num;
+};
+
+struct MergeResult {
+    double nanosPerPair;
+    double comparisonsPerPair;
+    size_t groups;
+};
+
+typedef std::vector<IntermediateVec> Runs;
+
+/**
+ * @brief Heap merge as in the original shuffle: push/pop per pair, two compares per boundary.
+ */
+static size_t heapMerge(const Runs& runs, IntermediateVec& out, std::vector<size_t>& offsets) {
+    using PQElement = std::tuple<K2*, V2*, int>;
+    auto comp = [](const PQElement& a, const PQElement& b) {
+        return *(std::get<0>(b)) < *(std::get<0>(a));
+    };
+    std::priority_queue<PQElement, std::vector<PQElement>, decltype(comp)> pq(comp);
+    std::vector<size_t> next(runs.size(), 1);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (!runs[i].empty()) pq.emplace(runs[i][0].first, runs[i][0].second, static_cast<int>(i));
+    }
+    while (!pq.empty()) {
+        K2* key = std::get<0>(pq.top());
+        while (!pq.empty() && !(*key < *std::get<0>(pq.top())) && !(*std::get<0>(pq.top()) < *key)) {
+            int i = std::get<2>(pq.top());
+            out.emplace_back(std::get<0>(pq.top()), std::get<1>(pq.top()));
+            pq.pop();
+            if (next[i] < runs[i].size()) {
+                const IntermediatePair& pair = runs[i][next[i]++];
+                pq.emplace(pair.first, pair.second, i);
+            }
+        }
+        offsets.push_back(out.size());
+    }
+    return offsets.size();
+}
+
+/**
+ * @brief Loser-tree merge as in the shuffle: one replay per pair, one compare per boundary.
+ */
+static size_t loserMerge(const Runs& runs, IntermediateVec& out, std::vector<size_t>& offsets) {
+    std::vector<size_t> next(runs.size(), 0);
+    auto headLess = [&runs, &next](int a, int b) {
+        return next[a] < runs[a].size() &&
+               (next[b] == runs[b].size() || *runs[a][next[a]].first < *runs[b][next[b]].first);
+    };
+    LoserTree<decltype(headLess)> tree(static_cast<int>(runs.size()), headLess);
+    while (next[tree.top()] < runs[tree.top()].size()) {
+        const K2* key = runs[tree.top()][next[tree.top()]].first;
+        do {
+            int i = tree.top();
+            out.push_back(runs[i][next[i]++]);
+            tree.replay();
+        } while (next[tree.top()] < runs[tree.top()].size() &&
+                 !(*key < *runs[tree.top()][next[tree.top()]].first));
+        offsets.push_back(out.size());
+    }
+    return offsets.size();
+}
+
+template <typename Merge>
+static MergeResult timeMerge(const Runs& runs, size_t pairs, Merge merge) {
+    IntermediateVec out;
+    out.reserve(pairs);
+    std::vector<size_t> offsets;
+    comparisons = 0;
+    auto start = std::chrono::steady_clock::now();
+    size_t groups = merge(runs, out, offsets);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return { std::chrono::duration<double, std::nano>(elapsed).count() / pairs,
+             static_cast<double>(comparisons) / pairs, groups };
+}
+
+int main(int argc, char** argv) {
+    size_t pairs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_PAIRS;
+    int maxRuns = argc > 2 ? std::atoi(argv[2]) : DEFAULT_MAX_RUNS;
+    int keys = argc > 3 ? std::atoi(argv[3]) : DEFAULT_KEYS;
+
+    std::mt19937 random(0);
+    std::vector<BenchKey> keyPool;
+    keyPool.reserve(pairs);
+    for (size_t i = 0; i < pairs; ++i) {
+        keyPool.emplace_back(static_cast<int>(random() % keys));
+    }
+
+    std::cout << "runs,heap_ns,loser_ns,heap_compares,loser_compares\n";
+    for (int k = MIN_RUNS; k <= maxRuns; k *= 2) {
+        Runs runs(k);
+        for (size_t i = 0; i < pairs; ++i) {
+            runs[i % k].emplace_back(&keyPool[i], nullptr);
+        }
+        for (IntermediateVec& run : runs) {
+            std::sort(run.begin(), run.end(), [](const IntermediatePair& a, const IntermediatePair& b) {
+                return *a.first < *b.first;
+            });
+        }
+        MergeResult heap = timeMerge(runs, pairs, heapMerge);
+        MergeResult loser = timeMerge(runs, pairs, loserMerge);
+        if (heap.groups != loser.groups) {
+            std::cerr << "merge_bench: group counts differ at " << k << " runs\n";
+            return 1;
+        }
+        std::cout << k << ',' << std::fixed << std::setprecision(1)
+                  << heap.nanosPerPair << ',' << loser.nanosPerPair << ','
+                  << std::setprecision(2) << heap.comparisonsPerPair << ','
+                  << loser.comparisonsPerPair << '\n';
+    }
+    return 0;
+}
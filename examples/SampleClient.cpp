@@ -56,6 +56,19 @@ public:
         }
     }
 
+    void combine(const IntermediateVec* pairs, void* context) const override {
+        char c = static_cast<const KChar*>(pairs->at(0).first)->c;
+        int count = 0;
+        for (const IntermediatePair& pair : *pairs) {
+            count += static_cast<const VCount*>(pair.second)->count;
+            delete pair.first;
+            delete pair.second;
+        }
+        emit2(new KChar(c), new VCount(count), context);
+    }
+
+    bool hasCombiner() const override { return true; }
+
     void reduce(const IntermediateVec* pairs, void* context) const override {
         char c = static_cast<const KChar*>(pairs->at(0).first)->c;
         int count = 0;
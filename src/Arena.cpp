@@ -0,0 +1,46 @@
+#include "Arena.h"
+
+// ======================[ Arena Implementation ]====================
+
+static const size_t ALIGNMENT = alignof(std::max_align_t);
+
+static size_t alignUp(size_t size) {
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+Arena::Arena(size_t blockSize)
+    : cursor(nullptr),
+      remaining(0),
+      blockSize(blockSize),
+      reserved(0)
+{ }
+
+void* Arena::allocate(size_t size) {
+    size = alignUp(size == 0 ? 1 : size);
+    if (size > remaining) {
+        // Oversized requests get a dedicated block so the current one is kept
+        bool dedicated = size > blockSize / 4;
+        size_t newBlock = dedicated ? size : blockSize;
+        blocks.emplace_back(new char[newBlock + ALIGNMENT]);
+        reserved += newBlock + ALIGNMENT;
+
+        char* raw = blocks.back().get();
+        char* aligned = raw + (ALIGNMENT - reinterpret_cast<size_t>(raw) % ALIGNMENT) % ALIGNMENT;
+        if (dedicated) {
+            return aligned;
+        }
+        cursor = aligned;
+        remaining = newBlock;
+    }
+    void* result = cursor;
+    cursor += size;
+    remaining -= size;
+    return result;
+}
+
+void Arena::release() {
+    blocks.clear();
+    cursor = nullptr;
+    remaining = 0;
+    reserved = 0;
+}
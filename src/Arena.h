@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Bump allocator that hands out memory from large blocks.
+ *
+ * Not thread-safe: each thread owns its own arena. Memory is only returned
+ * in bulk by release() or the destructor, and destructors of the objects
+ * placed in it are never run.
+ */
+class Arena {
+public:
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~Arena() = default;
+
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    /**
+     * @brief Returns size bytes aligned to alignof(std::max_align_t).
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief Frees every block at once.
+     */
+    void release();
+
+    /**
+     * @brief Total bytes reserved from the global heap.
+     */
+    size_t capacity() const { return reserved; }
+
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor;
+    size_t remaining;
+    size_t blockSize;
+    size_t reserved;
+};
+
+#endif // ARENA_H
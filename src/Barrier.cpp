@@ -1,14 +1,52 @@
 #include "Barrier.h"
+#include <thread>
+
+// ======================[ Helper Functions ]========================
+
+/**
+ * @brief Hints the core that the caller is in a spin-wait loop.
+ */
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief Drops the spin phase when the threads outnumber the hardware threads.
+ */
+static unsigned effectiveSpinLimit(int numThreads, unsigned spinLimit) {
+    unsigned hardware = std::thread::hardware_concurrency(); // 0 when unknown
+    if (hardware != 0 && static_cast<unsigned>(numThreads) > hardware) {
+        return 0;
+    }
+    return spinLimit;
+}
 
 // ======================[ Barrier Implementation ]==================
 
-Barrier::Barrier(int numThreads)
+Barrier::Barrier(int numThreads, unsigned spinLimit)
     : count(0),
       generation(0),
-      numThreads(numThreads)
+      numThreads(numThreads),
+      sensing(spinLimit > 0),
+      spinLimit(effectiveSpinLimit(numThreads, spinLimit)),
+      arrived(0),
+      sense(false),
+      sleepers(0)
 { }
 
 void Barrier::barrier() {
+    if (!sensing) {
+        blockingBarrier();
+    } else {
+        spinningBarrier();
+    }
+}
+
+void Barrier::blockingBarrier() {
     std::unique_lock<std::mutex> lock(mutex);
     int gen = generation;
 
@@ -20,3 +58,35 @@ void Barrier::barrier() {
         cv.notify_all();
     }
 }
+
+void Barrier::spinningBarrier() {
+    // Nobody can flip the sense before this thread arrives, so the round's
+    // target sense is simply the opposite of the current one
+    bool target = !sense.load(std::memory_order_relaxed);
+
+    if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == numThreads) {
+        arrived.store(0, std::memory_order_relaxed);
+        bool wake;
+        {
+            // Flipping under the mutex closes the gap before a waiter sleeps
+            std::lock_guard<std::mutex> lock(mutex);
+            sense.store(target, std::memory_order_release);
+            wake = sleepers > 0;
+        }
+        if (wake) {
+            cv.notify_all();
+        }
+        return;
+    }
+
+    for (unsigned spin = 0; spin < spinLimit; ++spin) {
+        if (sense.load(std::memory_order_acquire) == target) {
+            return;
+        }
+        cpuRelax();
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    ++sleepers;
+    cv.wait(lock, [this, target] { return sense.load(std::memory_order_acquire) == target; });
+    --sleepers;
+}
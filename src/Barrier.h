@@ -3,13 +3,21 @@
 
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 
 /**
  * @brief Barrier for synchronizing a fixed number of threads.
+ *
+ * With spinLimit 0 every waiter sleeps on a condition variable. Otherwise the
+ * barrier is sense-reversing: arrivals are counted atomically, waiters poll
+ * the shared sense up to spinLimit times and only then block, and the last
+ * thread issues a wake-up only when somebody actually went to sleep. Waiters
+ * skip the spin when there are more threads than hardware threads, since the
+ * thread they wait for may need their core to arrive.
  */
 class Barrier {
 public:
-    explicit Barrier(int numThreads);
+    explicit Barrier(int numThreads, unsigned spinLimit = 0);
     ~Barrier() = default;
 
     /**
@@ -18,11 +26,19 @@ public:
     void barrier();
 
 private:
+    void blockingBarrier();
+    void spinningBarrier();
+
     std::mutex mutex;
     std::condition_variable cv;
     int count;
     int generation;
     const int numThreads;
+    const bool sensing;                    // Sense-reversing variant selected
+    const unsigned spinLimit;              // Polls before sleeping (0 when oversubscribed)
+    std::atomic<int> arrived;              // Threads at the spinning barrier
+    std::atomic<bool> sense;               // Flipped by the last arrival
+    int sleepers;                          // Spinning waiters that blocked (guarded by mutex)
 };
 
 #endif // BARRIER_H
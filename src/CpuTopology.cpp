@@ -0,0 +1,98 @@
+#include "CpuTopology.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <pthread.h>
+#include <sched.h>
+
+// ======================[ Constants & Macros ]======================
+
+#define NODE_SYSFS_DIR "/sys/devices/system/node/node"
+#define MAX_NUMA_NODES 1024
+
+// ======================[ Helper Functions ]========================
+
+/**
+ * @brief Parses a sysfs cpulist such as "0-3,8,10-11".
+ */
+static std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range[0] == '\n') continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+/**
+ * @brief Reads the topology; CPUs outside every node list stay on node 0.
+ */
+static CpuTopology readCpuTopology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        CPU_SET(0, &allowed);
+    }
+
+    std::vector<int> nodeOf(CPU_SETSIZE, 0);
+    for (int node = 0; node < MAX_NUMA_NODES; ++node) {
+        std::ifstream file(NODE_SYSFS_DIR + std::to_string(node) + "/cpulist");
+        if (!file) {
+            if (node > 0) break; // Nodes are numbered densely on every machine we target
+            continue;
+        }
+        std::string list;
+        std::getline(file, list);
+        for (int cpu : parseCpuList(list)) {
+            if (cpu < CPU_SETSIZE) nodeOf[cpu] = node;
+        }
+    }
+
+    std::vector<std::pair<int, int>> placed;  // (node, cpu)
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            placed.emplace_back(nodeOf[cpu], cpu);
+        }
+    }
+    std::sort(placed.begin(), placed.end());
+
+    CpuTopology topology;
+    for (const std::pair<int, int>& entry : placed) {
+        topology.nodes.push_back(entry.first);
+        topology.cpus.push_back(entry.second);
+    }
+    return topology;
+}
+
+// ======================[ Topology API ]============================
+
+const CpuTopology& cpuTopology() {
+    static const CpuTopology topology = readCpuTopology();
+    return topology;
+}
+
+bool pinCurrentThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void unpinCurrentThread() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpuTopology().cpus) {
+        CPU_SET(cpu, &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
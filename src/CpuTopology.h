@@ -0,0 +1,35 @@
+#ifndef CPUTOPOLOGY_H
+#define CPUTOPOLOGY_H
+
+#include <vector>
+
+/**
+ * @brief The CPUs this process may run on, ordered node by node.
+ *
+ * Read once from sched_getaffinity and /sys/devices/system/node. CPUs that
+ * belong to no listed node (or machines without NUMA sysfs) count as node 0.
+ */
+struct CpuTopology {
+    std::vector<int> cpus;                 // Allowed CPU ids, grouped by node
+    std::vector<int> nodes;                // NUMA node of cpus[i]
+};
+
+/**
+ * @brief Returns the process-wide topology, reading it on first use.
+ */
+const CpuTopology& cpuTopology();
+
+/**
+ * @brief Binds the calling thread to one CPU.
+ *
+ * Placement is best effort: returns false and leaves the thread unbound if
+ * the kernel refuses (for example, the CPU left the process's cpuset).
+ */
+bool pinCurrentThread(int cpu);
+
+/**
+ * @brief Lets the calling thread run on every CPU in the topology again.
+ */
+void unpinCurrentThread();
+
+#endif // CPUTOPOLOGY_H
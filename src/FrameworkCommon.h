@@ -0,0 +1,87 @@
+#ifndef FRAMEWORKCOMMON_H
+#define FRAMEWORKCOMMON_H
+
+#include "MapReduceFramework.h"
+#include <iostream>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <cstdlib> // For exit()
+
+// ======================[ Constants & Macros ]======================
+
+#define SYSTEM_ERROR_MSG(msg) std::cerr << "system error: " << msg << std::endl
+#define EXIT_ON_ERROR(code) exit(code)
+#define ERROR_EXIT_CODE 1
+
+// ======================[ Job State Snapshot ]======================
+
+/**
+ * @brief A job's stage and its 64-bit total, published under a sequence word.
+ *
+ * The word holds the stage in bits 62-63 and below it a change counter that
+ * is odd while the stage is being replaced. A reader loads the word with
+ * begin, reads the total and whatever progress it needs, and retries unless
+ * validate sees the same word again. Only one thread changes the stage at a
+ * time, so the hot path never touches this object.
+ */
+class StageState {
+public:
+    StageState() : word(0), stageTotal(0) {}
+
+    /**
+     * @brief Starts a stage change; readers wait until endChange.
+     */
+    void beginChange() {
+        word.store(word.load(std::memory_order_relaxed) + 1);
+    }
+
+    /**
+     * @brief Publishes the new stage and total, ending the change.
+     */
+    void endChange(stage_t stage, uint64_t total) {
+        uint64_t sequence = (word.load(std::memory_order_relaxed) + 1) & SEQUENCE_MASK;
+        stageTotal.store(total);
+        word.store((static_cast<uint64_t>(stage) << STAGE_SHIFT) | sequence);
+    }
+
+    /**
+     * @brief Waits out any change in progress and returns the current word.
+     */
+    uint64_t begin() const {
+        uint64_t current;
+        while ((current = word.load()) & 1) {
+            std::this_thread::yield();
+        }
+        return current;
+    }
+
+    /**
+     * @brief True if nothing changed since begin returned snapshot.
+     */
+    bool validate(uint64_t snapshot) const { return word.load() == snapshot; }
+
+    uint64_t total() const { return stageTotal.load(); }
+
+    static stage_t stageOf(uint64_t snapshot) {
+        return static_cast<stage_t>(snapshot >> STAGE_SHIFT);
+    }
+
+private:
+    static const int STAGE_SHIFT = 62;
+    static const uint64_t SEQUENCE_MASK = (1ULL << STAGE_SHIFT) - 1;
+
+    std::atomic<uint64_t> word;
+    std::atomic<uint64_t> stageTotal;
+};
+
+/**
+ * @brief Fills a JobState from a stage snapshot and 64-bit counts.
+ */
+inline void fillJobState(uint64_t snapshot, uint64_t processed, uint64_t total, JobState* state) {
+    state->stage = StageState::stageOf(snapshot);
+    state->percentage = (total == 0) ? 100.0f :
+                        static_cast<float>(100.0 * static_cast<double>(processed) / total);
+}
+
+#endif // FRAMEWORKCOMMON_H
@@ -0,0 +1,68 @@
+#ifndef INPUTSOURCE_H
+#define INPUTSOURCE_H
+
+#include "MapReduceClient.h"
+#include <cstddef>
+
+// ======================[ InputSource Interface ]===================
+
+/**
+ * @brief Input of a MapReduce job, split into independently mappable chunks.
+ *
+ * Worker threads claim chunk indices atomically and call mapChunk
+ * concurrently for different chunks, so implementations must be safe for
+ * concurrent reads. The source must outlive the job.
+ */
+class InputSource {
+public:
+    virtual ~InputSource() {}
+
+    /**
+     * @brief Number of chunks; MAP_STAGE progress is reported in chunks.
+     */
+    virtual size_t chunkCount() const = 0;
+
+    /**
+     * @brief Calls client.map on every record of the given chunk.
+     */
+    virtual void mapChunk(size_t chunk, const MapReduceClient& client, void* context) const = 0;
+};
+
+/**
+ * @brief Adapts an InputVec: every element is a chunk of its own.
+ */
+class VectorInputSource : public InputSource {
+public:
+    explicit VectorInputSource(const InputVec& inputVec) : inputVec(inputVec) {}
+
+    size_t chunkCount() const override { return inputVec.size(); }
+
+    void mapChunk(size_t chunk, const MapReduceClient& client, void* context) const override {
+        client.map(inputVec[chunk].first, inputVec[chunk].second, context);
+    }
+
+private:
+    const InputVec& inputVec;
+};
+
+/**
+ * @brief Exposes the chunks [first, first + count) of another source.
+ */
+class RangeInputSource : public InputSource {
+public:
+    RangeInputSource(const InputSource& source, size_t first, size_t count)
+        : source(source), first(first), count(count) {}
+
+    size_t chunkCount() const override { return count; }
+
+    void mapChunk(size_t chunk, const MapReduceClient& client, void* context) const override {
+        source.mapChunk(first + chunk, client, context);
+    }
+
+private:
+    const InputSource& source;
+    size_t first;
+    size_t count;
+};
+
+#endif // INPUTSOURCE_H
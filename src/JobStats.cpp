@@ -0,0 +1,42 @@
+#include "JobStats.h"
+#include "FrameworkCommon.h"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+// ======================[ Stats Functions ]=========================
+
+const char* phaseName(job_phase_t phase) {
+    static const char* const names[PHASE_COUNT] = {
+        "map", "sort", "barrier", "shuffle", "reduce"
+    };
+    return (phase >= 0 && phase < PHASE_COUNT) ? names[phase] : "unknown";
+}
+
+void writeChromeTrace(const JobStats& stats, const std::string& path) {
+    std::ofstream out(path.c_str());
+    if (!out) {
+        SYSTEM_ERROR_MSG("failed to open trace file " << path << ": " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+
+    // Complete ("X") events with microsecond timestamps, one track per thread
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (size_t thread = 0; thread < stats.threads.size(); ++thread) {
+        for (const PhaseSpan& span : stats.threads[thread].spans) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":\"" << phaseName(span.phase) << "\",\"ph\":\"X\",\"pid\":0"
+                << ",\"tid\":" << thread
+                << ",\"ts\":" << span.beginNanos / 1000.0
+                << ",\"dur\":" << (span.endNanos - span.beginNanos) / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+
+    if (!out) {
+        SYSTEM_ERROR_MSG("failed to write trace file " << path);
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef JOBSTATS_H
+#define JOBSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ======================[ Constants & Macros ]======================
+
+#define GROUP_SIZE_BUCKETS 32
+#define HOT_KEY_MIN_PAIRS 1024
+#define HOT_KEY_SKEW_FACTOR 8
+
+// ======================[ Type Definitions ]========================
+
+/**
+ * @brief Phases a job thread spends its time in.
+ *
+ * PHASE_SORT covers the local sort and combine; the spills a thread writes
+ * while mapping count as PHASE_MAP. SHUFFLE_HASH jobs group their buckets
+ * inside PHASE_REDUCE.
+ */
+enum job_phase_t {
+    PHASE_MAP = 0,
+    PHASE_SORT = 1,
+    PHASE_BARRIER = 2,
+    PHASE_SHUFFLE = 3,
+    PHASE_REDUCE = 4,
+    PHASE_COUNT = 5
+};
+
+/**
+ * @brief One uninterrupted stretch of a phase, in nanoseconds since job start.
+ */
+struct PhaseSpan {
+    job_phase_t phase;
+    uint64_t beginNanos;
+    uint64_t endNanos;
+};
+
+/**
+ * @brief What one job thread did, recorded when JobOptions::collectStats is set.
+ */
+struct ThreadStats {
+    uint64_t wallNanos[PHASE_COUNT];       // Elapsed time per phase
+    uint64_t cpuNanos[PHASE_COUNT];        // Thread CPU time per phase
+    uint64_t emit2Count;                   // Pairs emitted by map and combine
+    uint64_t emit3Count;                   // Pairs emitted by reduce
+    uint64_t intermediateBytes;            // Pair buffer after map, plus bytes spilled
+    uint64_t groupSizeHistogram[GROUP_SIZE_BUCKETS]; // Bucket b: groups of [2^b, 2^(b+1)) pairs
+    std::vector<PhaseSpan> spans;          // Timeline for the Chrome trace
+
+    ThreadStats()
+        : wallNanos(),
+          cpuNanos(),
+          emit2Count(0),
+          emit3Count(0),
+          intermediateBytes(0),
+          groupSizeHistogram()
+    { }
+};
+
+/**
+ * @brief Sizes of the shuffled key groups (sorted, non-pipelined jobs only).
+ *
+ * A hot key is a group of at least HOT_KEY_MIN_PAIRS pairs holding more than
+ * HOT_KEY_SKEW_FACTOR times the mean group size.
+ */
+struct SkewStats {
+    uint64_t groups;                       // Shuffled key groups
+    uint64_t pairs;                        // Pairs in those groups
+    uint64_t largestGroupPairs;            // Pairs in the largest group
+    uint64_t hotKeys;                      // Groups flagged as hot keys
+    uint64_t hotKeyPairs;                  // Pairs in the hot-key groups
+
+    SkewStats()
+        : groups(0),
+          pairs(0),
+          largestGroupPairs(0),
+          hotKeys(0),
+          hotKeyPairs(0)
+    { }
+};
+
+/**
+ * @brief Per-thread statistics of a finished job.
+ */
+struct JobStats {
+    std::vector<ThreadStats> threads;
+    SkewStats skew;
+    int mapThreads;                        // Threads that ran the map phase
+    int reduceThreads;                     // Threads that ran the reduce phase
+
+    JobStats() : mapThreads(0), reduceThreads(0) { }
+};
+
+// ======================[ Stats Functions ]=========================
+
+/**
+ * @brief Short lowercase name of a phase ("map", "sort", ...).
+ */
+const char* phaseName(job_phase_t phase);
+
+/**
+ * @brief Writes the phase spans as Chrome trace JSON (chrome://tracing, Perfetto).
+ */
+void writeChromeTrace(const JobStats& stats, const std::string& path);
+
+#endif // JOBSTATS_H
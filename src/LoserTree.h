@@ -0,0 +1,64 @@
+#ifndef LOSERTREE_H
+#define LOSERTREE_H
+
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Tournament tree of losers for a k-way merge over sources 0..k-1.
+ *
+ * The caller keeps each source's current head; less(a, b) must order the
+ * heads of sources a and b and rank exhausted sources last. Each internal
+ * node holds the loser of the match played there and the overall winner
+ * sits at the root, so after the winner's head changes one replay up its
+ * leaf's path costs about log2(k) calls to less, against about 2 log2(k) for
+ * a binary heap's pop and push.
+ */
+template <typename Less>
+class LoserTree {
+public:
+    LoserTree(int sources, Less less)
+        : count(sources),
+          nodes(sources > 0 ? sources : 1, 0),
+          less(less)
+    {
+        // winners[n] is the winner below node n; leaves sit at count + i
+        std::vector<int> winners(2 * count);
+        for (int i = 0; i < count; ++i) {
+            winners[count + i] = i;
+        }
+        for (int n = count - 1; n >= 1; --n) {
+            int a = winners[2 * n];
+            int b = winners[2 * n + 1];
+            bool bWins = this->less(b, a);
+            winners[n] = bWins ? b : a;
+            nodes[n] = bWins ? a : b;
+        }
+        nodes[0] = count > 1 ? winners[1] : 0;
+    }
+
+    /**
+     * @brief Source with the smallest head (0 when there are no sources).
+     */
+    int top() const { return nodes[0]; }
+
+    /**
+     * @brief Restores the order after the head of top() advanced or ran out.
+     */
+    void replay() {
+        int winner = nodes[0];
+        for (int n = (count + winner) / 2; n >= 1; n /= 2) {
+            if (less(nodes[n], winner)) {
+                std::swap(nodes[n], winner);
+            }
+        }
+        nodes[0] = winner;
+    }
+
+private:
+    int count;
+    std::vector<int> nodes;                // nodes[0]: winner; nodes[n > 0]: loser at n
+    Less less;
+};
+
+#endif // LOSERTREE_H
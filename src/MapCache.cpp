@@ -0,0 +1,62 @@
+#include "MapCache.h"
+#include "SpillFile.h"
+
+// ======================[ MapCache Implementation ]=================
+
+MapCache::Entry::Entry() : fingerprint(0), reused(false) { }
+
+MapCache::Entry::~Entry() { }
+
+MapCache::Entry::Entry(Entry&& other)
+    : fingerprint(other.fingerprint),
+      run(std::move(other.run)),
+      reused(other.reused)
+{ }
+
+MapCache::MapCache(size_t chunksPerPartition, const std::string& directory)
+    : partitionChunks(chunksPerPartition > 0 ? chunksPerPartition : 1),
+      runDirectory(directory),
+      reused(0),
+      mapped(0)
+{ }
+
+MapCache::~MapCache() { }
+
+void MapCache::clear() {
+    entries.clear();
+}
+
+void MapCache::beginJob(size_t partitions) {
+    entries.resize(partitions);
+    for (Entry& entry : entries) {
+        entry.reused = false;
+    }
+    reused.store(0);
+    mapped.store(0);
+}
+
+bool MapCache::reuse(size_t partition, uint64_t fingerprint) {
+    Entry& entry = entries[partition];
+    if (!entry.run || entry.fingerprint != fingerprint) {
+        return false;
+    }
+    entry.run->rewind();
+    entry.reused = true;
+    reused.fetch_add(1);
+    return true;
+}
+
+void MapCache::store(size_t partition, uint64_t fingerprint, std::unique_ptr<SpillFile> run) {
+    Entry& entry = entries[partition];
+    entry.fingerprint = fingerprint;
+    entry.run = std::move(run);
+    mapped.fetch_add(1);
+}
+
+void MapCache::reusedRuns(std::vector<SpillFile*>* runs) const {
+    for (const Entry& entry : entries) {
+        if (entry.reused) {
+            runs->push_back(entry.run.get());
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef MAPCACHE_H
+#define MAPCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SpillFile;
+
+/**
+ * @brief Sorted map output of input partitions, kept from job to job.
+ *
+ * Partition p holds the input chunks [p * chunksPerPartition,
+ * (p + 1) * chunksPerPartition). A job started with JobOptions::mapCache
+ * asks the client for each partition's fingerprint and only maps the
+ * partitions whose fingerprint changed; the others feed their sorted run of
+ * serialized pairs from the previous job straight into the shuffle. Each
+ * cached partition keeps one unlinked file open in directory. A cache serves
+ * one job at a time and must outlive it.
+ */
+class MapCache {
+public:
+    explicit MapCache(size_t chunksPerPartition, const std::string& directory = "/tmp");
+    ~MapCache();
+
+    MapCache(const MapCache&) = delete;
+    MapCache& operator=(const MapCache&) = delete;
+
+    size_t chunksPerPartition() const { return partitionChunks; }
+    const std::string& directory() const { return runDirectory; }
+
+    /**
+     * @brief Partitions reused from the cache by the last job.
+     */
+    size_t reusedPartitions() const { return reused.load(); }
+
+    /**
+     * @brief Partitions mapped (and cached) by the last job.
+     */
+    size_t mappedPartitions() const { return mapped.load(); }
+
+    /**
+     * @brief Drops every cached run.
+     */
+    void clear();
+
+    // The framework's side, called while a job runs:
+
+    /**
+     * @brief Sizes the cache for a job's partitions and resets its counters.
+     */
+    void beginJob(size_t partitions);
+
+    /**
+     * @brief Marks partition reused if its run matches fingerprint; rewinds the run.
+     */
+    bool reuse(size_t partition, uint64_t fingerprint);
+
+    /**
+     * @brief Replaces a partition's run with the rewound run just mapped.
+     */
+    void store(size_t partition, uint64_t fingerprint, std::unique_ptr<SpillFile> run);
+
+    /**
+     * @brief Appends the runs of every partition reused by the current job.
+     */
+    void reusedRuns(std::vector<SpillFile*>* runs) const;
+
+private:
+    /**
+     * @brief One partition's cached run.
+     */
+    struct Entry {
+        uint64_t fingerprint;
+        std::unique_ptr<SpillFile> run;    // Null until the partition is mapped
+        bool reused;                       // Reused by the current job
+
+        Entry();
+        ~Entry();
+        Entry(Entry&& other);
+    };
+
+    size_t partitionChunks;
+    std::string runDirectory;
+    std::vector<Entry> entries;
+    std::atomic<size_t> reused;
+    std::atomic<size_t> mapped;
+};
+
+#endif // MAPCACHE_H
@@ -3,6 +3,11 @@
 
 #include <vector>
 #include <utility>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 // ======================[ Key/Value Base Classes ]==================
 
@@ -30,6 +35,16 @@ class K2 {
 public:
     virtual ~K2() {}
     virtual bool operator<(const K2& other) const = 0;
+
+    /**
+     * @brief Optionally writes a 64-bit sort prefix and returns true.
+     *
+     * The prefix must agree with operator<: a smaller prefix means a smaller
+     * key, and equivalent keys share a prefix. The framework then radix-sorts
+     * each thread's pairs by prefix and calls operator< only on prefix ties.
+     * Keys of one job must either all provide a prefix or none.
+     */
+    virtual bool sortPrefix(uint64_t* /*prefix*/) const { return false; }
 };
 
 /**
@@ -57,6 +72,84 @@ public:
     virtual ~V3() {}
 };
 
+// ======================[ Sort Prefix Helpers ]=====================
+
+/**
+ * @brief Order-preserving sort prefix of a signed integer key.
+ */
+inline uint64_t integerSortPrefix(int64_t value) {
+    return static_cast<uint64_t>(value) ^ (1ULL << 63);
+}
+
+/**
+ * @brief Sort prefix of a byte-string key: its first 8 bytes, big-endian.
+ *
+ * Strings that agree on their first 8 bytes tie and are ordered by operator<.
+ */
+inline uint64_t stringSortPrefix(const char* data, size_t size) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        unsigned char byte = i < size ? static_cast<unsigned char>(data[i]) : 0;
+        prefix = (prefix << 8) | byte;
+    }
+    return prefix;
+}
+
+// ======================[ Inline Pairs ]============================
+
+/**
+ * @brief An intermediate pair held by value: up to 8 bytes of key and of value.
+ *
+ * Jobs started with JobOptions::inlinePairs store these directly in each
+ * thread's buffer, so a pair costs no allocation. Keys are ordered by their
+ * bits as an unsigned integer; pack signed keys as integerSortPrefix(key).
+ */
+struct InlinePair {
+    uint64_t key;
+    uint64_t value;
+};
+
+/**
+ * @brief Packs a trivially copyable value of at most 8 bytes into inline bits.
+ */
+template <typename T>
+uint64_t toInlineBits(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(uint64_t),
+                  "inline pairs hold trivially copyable types of at most 8 bytes");
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(T));
+    return bits;
+}
+
+/**
+ * @brief Unpacks a value packed by toInlineBits.
+ */
+template <typename T>
+T fromInlineBits(uint64_t bits) {
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(uint64_t),
+                  "inline pairs hold trivially copyable types of at most 8 bytes");
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Typed view of one group of inline pairs, as given to reduceInline.
+ */
+template <typename K, typename V>
+class InlineSpan {
+public:
+    InlineSpan(const InlinePair* pairs, size_t count) : pairs(pairs), count(count) {}
+
+    K key() const { return fromInlineBits<K>(pairs[0].key); }
+    V value(size_t i) const { return fromInlineBits<V>(pairs[i].value); }
+    size_t size() const { return count; }
+
+private:
+    const InlinePair* pairs;
+    size_t count;
+};
+
 // ======================[ Type Definitions ]========================
 
 typedef std::pair<K1*, V1*> InputPair;
@@ -67,6 +160,37 @@ typedef std::vector<InputPair> InputVec;
 typedef std::vector<IntermediatePair> IntermediateVec;
 typedef std::vector<OutputPair> OutputVec;
 
+// ======================[ IntermediateSerializer Interface ]========
+
+/**
+ * @brief Converts intermediate pairs to and from bytes for spilled runs.
+ */
+class IntermediateSerializer {
+public:
+    virtual ~IntermediateSerializer() {}
+
+    /**
+     * @brief Appends the byte form of (key, value) to out.
+     */
+    virtual void serialize(const K2* key, const V2* value, std::string& out) const = 0;
+
+    /**
+     * @brief Rebuilds a pair written by serialize; it is then handled like an emitted pair.
+     */
+    virtual IntermediatePair deserialize(const char* data, size_t size) const = 0;
+
+    /**
+     * @brief Frees a pair once it has been written to disk.
+     *
+     * The default deletes the key and the value; override it for pairs
+     * placed with newIntermediate, which must not be deleted.
+     */
+    virtual void release(K2* key, V2* value) const {
+        delete key;
+        delete value;
+    }
+};
+
 // ======================[ MapReduceClient Interface ]===============
 
 /**
@@ -83,6 +207,68 @@ public:
      * @brief Reduce function: emits (K3, V3) pairs via emit3.
      */
     virtual void reduce(const IntermediateVec* pairs, void* context) const = 0;
+
+    /**
+     * @brief Combine function: pre-aggregates pairs of one thread sharing a key.
+     *
+     * Called only when hasCombiner() returns true, once per key that appears
+     * more than once in a thread's sorted run, before the shuffle. It must
+     * emit (via emit2) replacement pairs carrying that same key and release
+     * the pairs it was given, exactly as reduce does.
+     */
+    virtual void combine(const IntermediateVec* /*pairs*/, void* /*context*/) const { }
+
+    /**
+     * @brief Returns true if combine should be applied to the map output.
+     */
+    virtual bool hasCombiner() const { return false; }
+
+    /**
+     * @brief Reduce over one group viewed in place in the shuffle's pair buffer.
+     *
+     * Called instead of reduce when hasSpanReduce() returns true, which spares
+     * copying every group into an IntermediateVec. The pairs must be released
+     * exactly as in reduce.
+     */
+    virtual void reduceSpan(const IntermediatePair* /*pairs*/, size_t /*count*/,
+                            void* /*context*/) const { }
+
+    /**
+     * @brief Returns true if reduceSpan should be called instead of reduce.
+     */
+    virtual bool hasSpanReduce() const { return false; }
+
+    /**
+     * @brief Releases pairs that a cancelled job will never reduce.
+     *
+     * Called instead of reduce (or combine) once cancelJob or the deadline
+     * stops the job; the pairs need not share a key. The default deletes
+     * both objects of each pair; override it for pairs placed with
+     * newIntermediate, which must not be deleted.
+     */
+    virtual void discard(const IntermediatePair* pairs, size_t count, void* /*context*/) const {
+        for (size_t i = 0; i < count; ++i) {
+            delete pairs[i].first;
+            delete pairs[i].second;
+        }
+    }
+
+    /**
+     * @brief Frees an output pair that a JobOptions::topK job does not keep.
+     */
+    virtual void releaseOutput(K3* key, V3* value) const {
+        delete key;
+        delete value;
+    }
+
+    /**
+     * @brief Reduce over one group of inline pairs (JobOptions::inlinePairs jobs).
+     *
+     * The count pairs share one key and live in the job's buffer, which the
+     * framework frees; wrap them in an InlineSpan to read typed keys and values.
+     */
+    virtual void reduceInline(const InlinePair* /*pairs*/, size_t /*count*/,
+                              void* /*context*/) const { }
 };
 
 #endif // MAPREDUCECLIENT_H
@@ -1,189 +1,2344 @@
 #include "MapReduceFramework.h"
+#include "FrameworkCommon.h"
 #include "Barrier.h"
+#include "Arena.h"
+#include "SpillFile.h"
+#include "CpuTopology.h"
+#include "LoserTree.h"
 #include <thread>
-#include <iostream>
+#include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <algorithm>
-#include <queue>
-#include <cstdlib> // For exit()
+#include <iterator>
+#include <functional>
+#include <unordered_map>
+#include <memory>
+#include <limits>
+#include <deque>
+#include <chrono>
+#include <time.h>
+#include <arpa/inet.h>
 
 // ======================[ Constants & Macros ]======================
 
-#define SYSTEM_ERROR_MSG(msg) std::cerr << "system error: " << msg << std::endl
-#define EXIT_ON_ERROR(code) exit(code)
-#define ERROR_EXIT_CODE 1
+#define SPLITTER_SAMPLES_PER_THREAD 32
+#define PIPELINE_PUBLISH_PAIRS 1024
+#define HASH_PARTITIONS_PER_THREAD 4
+#define GUIDED_BATCH_DIVISOR 2
+#define RADIX_SORT_MIN_PAIRS 256
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define CANCEL_POLL_INTERVAL 256
+#define AUTO_PROBE_CHUNKS 64
+#define AUTO_MAP_NANOS_PER_THREAD 2000000
+#define AUTO_GROUPS_PER_THREAD 256
+#define STAGE_TAG_SHIFT 62
+#define PROGRESS_COUNT_MASK ((1ULL << STAGE_TAG_SHIFT) - 1)
+#define CLUSTER_SEND_BUFFER_BYTES (1 << 20)
+#define FRAME_RUN_END 0xFFFFFFFFu
+#define FRAME_STREAM_END 0xFFFFFFFEu
 
 
 // Forward declaration for JobContext (used in ThreadContext)
 struct JobContext;
 
+/**
+ * @brief One unit of scheduled reduce work: a whole group, or one slice of a
+ * split group that is combined on its own.
+ */
+struct ReduceTask {
+    size_t group;                          // Index into shuffledGroups
+    size_t begin;                          // Slice bounds within the group
+    size_t end;
+    int split;                             // Index into splitGroups, or -1
+};
+
+/**
+ * @brief Partial results of an oversized group reduced in slices.
+ */
+struct SplitGroup {
+    size_t sliceSize;                      // Pairs per slice (the last may be shorter)
+    std::vector<IntermediateVec> partials; // Combined output of each slice
+    std::atomic<size_t> pending;           // Slices not yet combined
+};
+
 // ======================[ Internal Structs ]========================
 
 /**
- * @brief Context for a single thread in the MapReduce job.
+ * @brief Shuffled groups stored back to back in one pair buffer.
+ *
+ * Group i spans pairs [offsets[i], offsets[i + 1]), so a group costs one
+ * offset instead of a vector and its allocation.
+ */
+struct GroupBuffer {
+    IntermediateVec pairs;                 // Every group's pairs, in key order
+    std::vector<size_t> offsets;           // Group boundaries; starts with 0
+    size_t unreduced;                      // Groups not yet reduced (pipelined)
+
+    GroupBuffer() : offsets(1, 0), unreduced(0) {}
+
+    size_t groups() const { return offsets.size() - 1; }
+    void endGroup() { offsets.push_back(pairs.size()); }
+};
+
+/**
+ * @brief View of one shuffled group inside a GroupBuffer.
+ */
+struct GroupSpan {
+    const IntermediatePair* pairs;
+    size_t size;
+    size_t buffer;                         // Index into shuffleBuffers
+};
+
+/**
+ * @brief A sorted slice [begin, end) of one thread's intermediate vector,
+ * or a whole spilled run when spill is set.
+ */
+struct RunSlice {
+    const IntermediatePair* begin;
+    const IntermediatePair* end;
+    SpillFile* spill;
+};
+
+/**
+ * @brief Context for a single thread in the MapReduce job.
+ */
+struct ThreadContext {
+    int threadID;
+    JobContext* job;
+    IntermediateVec intermediateVec;
+    std::vector<InlinePair> inlineVec;     // Pairs emitted by emitInline (inlinePairs only)
+    std::vector<IntermediateVec> partitions; // Hash buckets (SHUFFLE_HASH only)
+    Arena arena;                           // Client allocations, freed with the job
+    std::vector<std::unique_ptr<SpillFile>> spills; // Sorted runs written to disk
+    bool combining;                        // Suppresses spilling while combine emits
+    std::atomic<uint64_t> progress;        // Stage tag (top 2 bits) | items processed
+    OutputVec outputVec;                   // Pairs emitted by this thread's reduce calls
+    IntermediateVec reduceScratch;         // A group copied out for IntermediateVec reducers
+    IntermediateVec* recycled;             // Runtime worker's buffer, lent for the job
+    int cpu;                               // CPU the thread pins itself to, or -1
+    int node;                              // NUMA node of cpu, or -1
+    ThreadStats stats;                     // Counters always; times only with collectStats
+    job_phase_t phase;                     // Phase being timed, or PHASE_COUNT
+    uint64_t phaseWallStart;               // When the current phase began
+    uint64_t phaseCpuStart;
+    unsigned cancelPolls;                  // Items since the deadline was last read
+
+    ThreadContext(int id, JobContext* jobContext)
+        : threadID(id), job(jobContext), intermediateVec(), combining(false), progress(0),
+          recycled(nullptr), cpu(-1), node(-1), phase(PHASE_COUNT), phaseWallStart(0),
+          phaseCpuStart(0), cancelPolls(0) {}
+
+    ThreadContext(ThreadContext&& other)
+        : threadID(other.threadID),
+          job(other.job),
+          intermediateVec(std::move(other.intermediateVec)),
+          inlineVec(std::move(other.inlineVec)),
+          partitions(std::move(other.partitions)),
+          arena(std::move(other.arena)),
+          spills(std::move(other.spills)),
+          combining(other.combining),
+          progress(other.progress.load()),
+          outputVec(std::move(other.outputVec)),
+          reduceScratch(std::move(other.reduceScratch)),
+          recycled(other.recycled),
+          cpu(other.cpu),
+          node(other.node),
+          stats(std::move(other.stats)),
+          phase(other.phase),
+          phaseWallStart(other.phaseWallStart),
+          phaseCpuStart(other.phaseCpuStart),
+          cancelPolls(other.cancelPolls) {}
+};
+
+/**
+ * @brief Context for the entire MapReduce job.
+ */
+struct JobContext {
+    const MapReduceClient* client;         // Client's map/reduce implementation
+    const InputSource* input;              // Input chunks for map phase
+    std::unique_ptr<InputSource> ownedInput; // Adapter owned by InputVec jobs
+    std::unique_ptr<InputSource> rankInput; // This node's share of the input (cluster)
+    std::unique_ptr<PeerMesh> mesh;        // Sockets to the other nodes (cluster)
+    size_t chunkCount;                     // Number of input chunks
+    size_t cachePartitions;                // MapCache partitions of the input (mapCache)
+    std::vector<SpillFile*> cachedRuns;    // Reused MapCache runs, merged by the shuffle
+    std::mutex chunksMutex;                // Guards the sort chunk fields below (and mapCache runs)
+    std::condition_variable chunksReady;   // Signals a pending chunk or the end of map
+    std::vector<IntermediateVec> pendingChunks; // Full buffers waiting to be sorted
+    std::vector<IntermediateVec> sortedChunks; // Sorted (and combined) chunks and mapped partitions
+    int mappingThreads;                    // Threads still mapping (sortChunkPairs)
+    OutputVec* outputVec;                  // Final output vector (from reduce)
+    int threadCount;                       // Number of worker threads
+    int mapThreads;                        // Threads that map (the first ones)
+    int reduceThreads;                     // Threads that reduce (the first ones)
+    bool mapThreadsDecided;                // Set once autoThreads has sized the map phase
+    std::mutex threadsMutex;               // Guards mapThreads while it is being decided
+    std::condition_variable threadsDecided; // Signals mapThreadsDecided
+    int partitionCount;                    // Hash partitions (SHUFFLE_HASH only)
+    size_t spillThreshold;                 // Per-thread buffer size that triggers a spill
+    size_t chunkThreshold;                 // Per-thread buffer size that ends a sort chunk
+    JobOptions options;                    // Settings chosen at job start
+    std::vector<std::thread> threads;      // Thread objects
+    std::vector<ThreadContext> threadContexts; // Thread contexts
+    std::atomic<size_t> vecIndex;          // Index for work distribution
+    StageState stageState;                 // Stage and total (progress is per thread)
+    Barrier barrier;                       // Barrier for thread synchronization
+    std::atomic<int> finishedThreads;      // Threads done with every stage
+    std::deque<GroupBuffer> shuffleBuffers; // Shuffled pairs (one buffer per range or batch)
+    std::vector<GroupSpan> shuffledGroups; // Every shuffled group, in key order
+    std::vector<InlinePair> inlinePairs;   // Merged inline pairs (inlinePairs only)
+    std::vector<size_t> inlineOffsets;     // Inline group i spans [offsets[i], offsets[i + 1])
+    std::vector<ReduceTask> reduceTasks;   // Reduce schedule (empty: key order)
+    size_t sliceTasks;                     // Leading reduceTasks that are group slices
+    std::vector<std::unique_ptr<SplitGroup>> splitGroups; // Groups reduced in slices
+    SkewStats skew;                        // Shuffled group sizes (collectStats, splitHotKeys)
+    size_t hotKeyThreshold;                // Larger groups are hot keys (set by measureSkew)
+    std::vector<std::vector<RunSlice>> rangeSlices; // Run slices per key range
+    std::vector<size_t> rangeOffsets;      // First shuffled group of each key range (pinned)
+    std::unique_ptr<std::atomic<size_t>[]> rangeCursors; // Next unclaimed group per range
+    std::mutex groupsMutex;                // Guards the pipelined reduce fields below
+    std::condition_variable groupsReady;   // Signals newly published groups
+    size_t nextGroup;                      // Next unclaimed published group
+    size_t reducedGroups;                  // Groups reduced so far (pipelined)
+    int activeShufflers;                   // Threads still publishing groups
+    uint64_t startNanos;                   // Job start on the steady clock (collectStats)
+    uint64_t deadlineNanos;                // Steady clock time that cancels the job, or 0
+    std::atomic<bool> cancelled;           // Set by cancelJob or an expired deadline
+    std::mutex doneMutex;                  // Guards done
+    std::condition_variable doneCv;        // Signals that the output is complete
+    bool done;                             // Set by the last thread to finish
+    bool calledWaitForJob;                 // Ensures waitForJob is called once
+
+    JobContext(const MapReduceClient* client,
+               const InputSource* input,
+               OutputVec* outputVec,
+               int threadCount,
+               const JobOptions& options)
+        : client(client),
+          input(input),
+          chunkCount(input->chunkCount()),
+          cachePartitions(0),
+          mappingThreads(threadCount),
+          outputVec(outputVec),
+          threadCount(threadCount),
+          mapThreads(options.mapThreads > 0 ? std::min(options.mapThreads, threadCount) : threadCount),
+          reduceThreads(options.reduceThreads > 0 ? std::min(options.reduceThreads, threadCount) :
+                        threadCount),
+          mapThreadsDecided(!options.autoThreads),
+          partitionCount(0),
+          spillThreshold(std::numeric_limits<size_t>::max()),
+          chunkThreshold(std::numeric_limits<size_t>::max()),
+          options(options),
+          vecIndex(0),
+          barrier(threadCount, options.barrierSpins),
+          finishedThreads(0),
+          sliceTasks(0),
+          hotKeyThreshold(std::numeric_limits<size_t>::max()),
+          nextGroup(0),
+          reducedGroups(0),
+          activeShufflers(1),
+          startNanos(0),
+          deadlineNanos(0),
+          cancelled(false),
+          done(false),
+          calledWaitForJob(false)
+    {
+        threadContexts.reserve(threadCount);
+        for (int i = 0; i < threadCount; ++i) {
+            threadContexts.emplace_back(i, this);
+        }
+        if (this->options.shuffleMode == SHUFFLE_HASH && this->options.keyHash == nullptr) {
+            this->options.shuffleMode = SHUFFLE_SERIAL;
+        }
+        if (this->options.inlinePairs) {
+            this->options.shuffleMode = SHUFFLE_SERIAL;
+            this->options.pipelineReduce = false;
+            this->options.memoryBudget = 0;
+            this->options.sortChunkPairs = 0;
+            this->options.reduceOrder = REDUCE_KEY_ORDER;
+            this->options.splitGroupPairs = 0;
+            this->options.splitHotKeys = false;
+            this->options.cluster = nullptr;
+            this->options.mapCache = nullptr;
+        }
+        if (this->options.cluster != nullptr && this->options.serializer == nullptr) {
+            this->options.cluster = nullptr;
+        }
+        if (this->options.cluster != nullptr) {
+            const ClusterSpec& cluster = *this->options.cluster;
+            this->options.shuffleMode = SHUFFLE_SERIAL;
+            this->options.pipelineReduce = false;
+            mesh.reset(new PeerMesh(cluster));
+            if (cluster.splitInput) {
+                size_t nodes = cluster.nodes.size();
+                size_t rank = static_cast<size_t>(cluster.rank);
+                size_t first = chunkCount * rank / nodes;
+                size_t last = chunkCount * (rank + 1) / nodes;
+                rankInput.reset(new RangeInputSource(*input, first, last - first));
+                this->input = rankInput.get();
+                chunkCount = last - first;
+            }
+        }
+        if (this->options.mapCache != nullptr &&
+            (this->options.serializer == nullptr || this->options.partitionFingerprint == nullptr ||
+             this->options.shuffleMode == SHUFFLE_HASH || this->options.cluster != nullptr)) {
+            this->options.mapCache = nullptr;
+        }
+        if (this->options.mapCache != nullptr) {
+            size_t span = this->options.mapCache->chunksPerPartition();
+            cachePartitions = (chunkCount + span - 1) / span;
+            this->options.mapCache->beginJob(cachePartitions);
+            this->options.shuffleMode = SHUFFLE_SERIAL;
+            this->options.memoryBudget = 0;
+        }
+        if (this->options.memoryBudget > 0 && this->options.serializer != nullptr &&
+            this->options.shuffleMode != SHUFFLE_HASH) {
+            spillThreshold = std::max<size_t>(1, this->options.memoryBudget / threadCount);
+            this->options.shuffleMode = SHUFFLE_SERIAL;
+        }
+        const CpuTopology& topology = cpuTopology();
+        if (this->options.pinThreads && !topology.cpus.empty()) {
+            for (ThreadContext& tc : threadContexts) {
+                size_t slot = static_cast<size_t>(tc.threadID) * topology.cpus.size() / threadCount;
+                tc.cpu = topology.cpus[slot];
+                tc.node = topology.nodes[slot];
+            }
+        }
+        if (this->options.shuffleMode == SHUFFLE_HASH) {
+            partitionCount = threadCount * HASH_PARTITIONS_PER_THREAD;
+            for (ThreadContext& tc : threadContexts) {
+                tc.partitions.resize(partitionCount);
+            }
+        }
+        if (this->options.outputSink != nullptr) {
+            this->options.topK = 0;
+        }
+        if (this->options.mapCache != nullptr) {
+            mapThreadsDecided = true;           // Partitions, not chunks, are claimed
+        }
+        if (this->options.sortChunkPairs > 0 && this->options.shuffleMode != SHUFFLE_HASH &&
+            spillThreshold == std::numeric_limits<size_t>::max() &&
+            this->options.mapCache == nullptr && this->options.cluster == nullptr) {
+            chunkThreshold = this->options.sortChunkPairs;
+        }
+        if (this->options.shuffleMode == SHUFFLE_PARALLEL) {
+            activeShufflers = threadCount;      // Only once every fallback to SHUFFLE_SERIAL is made
+        }
+    }
+};
+
+// ======================[ Progress & Scheduling ]===================
+
+/**
+ * @brief Adds count to the calling thread's progress in the current stage.
+ *
+ * Between stage changes only the owning thread writes its counter, so a
+ * relaxed load and store replace a locked read-modify-write.
+ */
+static void addProgress(ThreadContext* tc, uint64_t count) {
+    uint64_t value = tc->progress.load(std::memory_order_relaxed);
+    tc->progress.store(value + count, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Publishes a stage and total, crediting work already done in it.
+ *
+ * Must run while no other thread reports progress. The stage is published
+ * before the counters are retagged, so getJobState, which only sums counters
+ * tagged with the stage it read and re-checks the stage, never mixes stages.
+ */
+static void publishStage(JobContext* job, stage_t stage, uint64_t total, uint64_t credit) {
+    uint64_t tag = static_cast<uint64_t>(stage) << STAGE_TAG_SHIFT;
+    job->stageState.beginChange();
+    job->stageState.endChange(stage, total);
+    for (ThreadContext& tc : job->threadContexts) {
+        tc.progress.store(tag);
+    }
+    job->threadContexts[0].progress.store(tag | credit);
+}
+
+/**
+ * @brief Moves the job to a new stage (see publishStage).
+ *
+ * The client's onStage callback runs last, once the new stage is visible.
+ */
+static void setStage(JobContext* job, stage_t stage, uint64_t total, uint64_t credit = 0) {
+    publishStage(job, stage, total, credit);
+    if (job->options.onStage != nullptr) {
+        job->options.onStage(job, stage, job->options.callbackData);
+    }
+}
+
+/**
+ * @brief Claims the next batch of the items [0, total) with guided scheduling.
+ *
+ * Batches start at remaining / (GUIDED_BATCH_DIVISOR * threadCount) items and
+ * shrink toward one as the work runs out, so the shared index is updated a
+ * logarithmic number of times per thread instead of once per item.
+ */
+static bool claimBatch(JobContext* job, size_t total, size_t* first, size_t* count,
+                       size_t maxBatch = std::numeric_limits<size_t>::max()) {
+    size_t current = job->vecIndex.load(std::memory_order_relaxed);
+    while (current < total) {
+        size_t remaining = total - current;
+        size_t batch = std::max<size_t>(1, remaining / (GUIDED_BATCH_DIVISOR * job->threadCount));
+        batch = std::min(batch, maxBatch);
+        if (job->vecIndex.compare_exchange_weak(current, current + batch)) {
+            *first = current;
+            *count = batch;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Sizes the reduce phase from its group count (autoThreads; thread 0 only).
+ */
+static void chooseReduceThreads(JobContext* job, size_t groups) {
+    if (!job->options.autoThreads) return;
+    size_t wanted = std::max<size_t>(1, groups / AUTO_GROUPS_PER_THREAD);
+    job->reduceThreads = static_cast<int>(std::min<size_t>(wanted, job->reduceThreads));
+}
+
+// ======================[ Instrumentation ]=========================
+
+static uint64_t wallNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t threadCpuNanos() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * @brief Closes the thread's current phase and starts timing the next one.
+ *
+ * A no-op unless the job collects stats; PHASE_COUNT stops timing.
+ */
+static void switchPhase(ThreadContext* tc, job_phase_t next) {
+    if (!tc->job->options.collectStats) return;
+    uint64_t wall = wallNanos();
+    uint64_t cpu = threadCpuNanos();
+    if (tc->phase != PHASE_COUNT) {
+        tc->stats.wallNanos[tc->phase] += wall - tc->phaseWallStart;
+        tc->stats.cpuNanos[tc->phase] += cpu - tc->phaseCpuStart;
+        tc->stats.spans.push_back({tc->phase, tc->phaseWallStart - tc->job->startNanos,
+                                   wall - tc->job->startNanos});
+    }
+    tc->phase = next;
+    tc->phaseWallStart = wall;
+    tc->phaseCpuStart = cpu;
+}
+
+/**
+ * @brief Waits at the job barrier, timed as PHASE_BARRIER.
+ */
+static void waitAtBarrier(ThreadContext* tc) {
+    job_phase_t phase = tc->phase;
+    switchPhase(tc, PHASE_BARRIER);
+    tc->job->barrier.barrier();
+    switchPhase(tc, phase);
+}
+
+/**
+ * @brief Returns true once the job is cancelled, latching an expired deadline first.
+ */
+static bool checkCancelled(JobContext* job) {
+    if (job->cancelled.load(std::memory_order_relaxed)) return true;
+    if (job->deadlineNanos != 0 && wallNanos() >= job->deadlineNanos) {
+        job->cancelled.store(true);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Per-item cancellation check: reads the deadline every CANCEL_POLL_INTERVAL calls.
+ */
+static bool pollCancelled(ThreadContext* tc) {
+    if (++tc->cancelPolls < CANCEL_POLL_INTERVAL) {
+        return tc->job->cancelled.load(std::memory_order_relaxed);
+    }
+    tc->cancelPolls = 0;
+    return checkCancelled(tc->job);
+}
+
+/**
+ * @brief Returns true if a cancelled job may leave its runs unsorted.
+ *
+ * Cluster nodes still sort: their runs are cut at the splitters and
+ * merged by the other nodes, whose jobs go on.
+ */
+static bool skipSorting(JobContext* job) {
+    return !job->mesh && checkCancelled(job);
+}
+
+/**
+ * @brief Hands pairs that will not be reduced to the client's discard.
+ */
+static void discardPairs(ThreadContext* tc, const IntermediatePair* pairs, size_t count) {
+    if (count > 0) {
+        tc->job->client->discard(pairs, count, tc);
+    }
+}
+
+/**
+ * @brief Records the size of the thread's map output (with collectStats).
+ */
+static void recordIntermediateBytes(ThreadContext* tc) {
+    if (!tc->job->options.collectStats) return;
+    uint64_t bytes = tc->intermediateVec.size() * sizeof(IntermediatePair) +
+                     tc->inlineVec.size() * sizeof(InlinePair);
+    for (const IntermediateVec& bucket : tc->partitions) {
+        bytes += bucket.size() * sizeof(IntermediatePair);
+    }
+    for (const std::unique_ptr<SpillFile>& spill : tc->spills) {
+        bytes += spill->bytes();
+    }
+    tc->stats.intermediateBytes += bytes;
+}
+
+/**
+ * @brief Counts a reduced group in the group-size histogram (with collectStats).
+ */
+static void recordGroupSize(ThreadContext* tc, size_t size) {
+    if (!tc->job->options.collectStats) return;
+    int bucket = 0;
+    for (; size > 1 && bucket + 1 < GROUP_SIZE_BUCKETS; size >>= 1) {
+        ++bucket;
+    }
+    ++tc->stats.groupSizeHistogram[bucket];
+}
+
+/**
+ * @brief Calls the client's reduce on one group held in a vector.
+ */
+static void reduceGroup(ThreadContext* tc, const IntermediateVec* group) {
+    if (pollCancelled(tc)) {
+        discardPairs(tc, group->data(), group->size());
+        return;
+    }
+    const MapReduceClient* client = tc->job->client;
+    recordGroupSize(tc, group->size());
+    if (client->hasSpanReduce()) {
+        client->reduceSpan(group->data(), group->size(), tc);
+    } else {
+        client->reduce(group, tc);
+    }
+}
+
+/**
+ * @brief Calls the client's reduce on one group viewed in a GroupBuffer.
+ *
+ * Clients without reduceSpan get the group copied into the thread's scratch
+ * vector, whose capacity is reused from group to group.
+ */
+static void reduceGroup(ThreadContext* tc, const GroupSpan& group) {
+    if (pollCancelled(tc)) {
+        discardPairs(tc, group.pairs, group.size);
+        return;
+    }
+    const MapReduceClient* client = tc->job->client;
+    recordGroupSize(tc, group.size);
+    if (client->hasSpanReduce()) {
+        client->reduceSpan(group.pairs, group.size, tc);
+        return;
+    }
+    tc->reduceScratch.assign(group.pairs, group.pairs + group.size);
+    client->reduce(&tc->reduceScratch, tc);
+    tc->reduceScratch.clear();
+}
+
+// ======================[ Combine Stage ]===========================
+
+/**
+ * @brief Runs the client's combiner over each key group of a sorted run.
+ *
+ * The run is moved out of the thread's intermediate vector, so the pairs
+ * emitted by combine land in a fresh vector that stays sorted. Keys that
+ * appear once are carried over without calling combine.
+ */
+static void combineSortedRun(ThreadContext* tc) {
+    const MapReduceClient* client = tc->job->client;
+    IntermediateVec run;
+    run.swap(tc->intermediateVec);
+    tc->combining = true;
+    tc->intermediateVec.reserve(run.size() / 2 + 1);
+
+    IntermediateVec group;
+    size_t begin = 0;
+    while (begin < run.size()) {
+        size_t end = begin + 1;
+        // The run is sorted, so run[end] is equivalent unless run[begin] < run[end]
+        while (end < run.size() && !(*run[begin].first < *run[end].first)) {
+            ++end;
+        }
+        if (end - begin == 1) {
+            tc->intermediateVec.push_back(run[begin]);
+        } else {
+            group.assign(run.begin() + begin, run.begin() + end);
+            client->combine(&group, tc);
+        }
+        begin = end;
+    }
+    tc->combining = false;
+}
+
+/**
+ * @brief An intermediate pair tagged with its key's sort prefix.
+ */
+struct PrefixedPair {
+    uint64_t prefix;
+    IntermediatePair pair;
+};
+
+static bool pairLess(const IntermediatePair& a, const IntermediatePair& b) {
+    return *(a.first) < *(b.first);
+}
+
+/**
+ * @brief Stable LSD radix sort of items by the 64-bit key that keyOf returns.
+ *
+ * Digit positions where every key has the same byte are skipped, so small
+ * integer keys take one or two passes.
+ */
+template <typename Item, typename KeyOf>
+static void radixSortItems(std::vector<Item>& items, KeyOf keyOf) {
+    if (items.empty()) return;
+    std::vector<Item> buffer(items.size());
+    for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+        size_t counts[RADIX_BUCKETS] = {0};
+        for (const Item& item : items) {
+            ++counts[(keyOf(item) >> shift) & (RADIX_BUCKETS - 1)];
+        }
+        if (counts[(keyOf(items[0]) >> shift) & (RADIX_BUCKETS - 1)] == items.size()) {
+            continue;
+        }
+        size_t offset = 0;
+        for (size_t& count : counts) {
+            size_t bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+        for (const Item& item : items) {
+            buffer[counts[(keyOf(item) >> shift) & (RADIX_BUCKETS - 1)]++] = item;
+        }
+        items.swap(buffer);
+    }
+}
+
+/**
+ * @brief LSD radix sort of vec by K2::sortPrefix, breaking ties with operator<.
+ *
+ * Returns false, leaving vec untouched, if a key provides no prefix.
+ */
+static bool radixSortByPrefix(IntermediateVec& vec) {
+    std::vector<PrefixedPair> items(vec.size());
+    for (size_t i = 0; i < vec.size(); ++i) {
+        if (!vec[i].first->sortPrefix(&items[i].prefix)) {
+            return false;
+        }
+        items[i].pair = vec[i];
+    }
+    radixSortItems(items, [](const PrefixedPair& item) { return item.prefix; });
+
+    size_t begin = 0;
+    while (begin < items.size()) {
+        size_t end = begin + 1;
+        while (end < items.size() && items[end].prefix == items[begin].prefix) {
+            ++end;
+        }
+        if (end - begin > 1) {
+            // Exact prefixes (integer keys) leave runs of equal keys: one scan
+            auto itemLess = [](const PrefixedPair& a, const PrefixedPair& b) {
+                return pairLess(a.pair, b.pair);
+            };
+            if (!std::is_sorted(items.begin() + begin, items.begin() + end, itemLess)) {
+                std::sort(items.begin() + begin, items.begin() + end, itemLess);
+            }
+        }
+        begin = end;
+    }
+    for (size_t i = 0; i < items.size(); ++i) {
+        vec[i] = items[i].pair;
+    }
+    return true;
+}
+
+/**
+ * @brief Sorts the thread's intermediate vector by key, then combines it.
+ *
+ * Large vectors whose keys expose a sort prefix are radix-sorted; the rest
+ * go through std::sort with K2::operator<.
+ */
+static void sortAndCombine(ThreadContext* tc) {
+    IntermediateVec& vec = tc->intermediateVec;
+    if (vec.size() < RADIX_SORT_MIN_PAIRS || !radixSortByPrefix(vec)) {
+        std::sort(vec.begin(), vec.end(), pairLess);
+    }
+    if (tc->job->client->hasCombiner()) {
+        combineSortedRun(tc);
+    }
+}
+
+// ======================[ Sort Chunks ]=============================
+
+/**
+ * @brief Hands the thread's full buffer to the sorters and starts a new one.
+ *
+ * The new buffer is reserved up front unless this is the thread's last
+ * hand-off, after which it maps no more pairs.
+ */
+static void publishChunk(ThreadContext* tc, bool last = false) {
+    JobContext* job = tc->job;
+    if (job->options.collectStats) {
+        tc->stats.intermediateBytes += tc->intermediateVec.size() * sizeof(IntermediatePair);
+    }
+    {
+        std::unique_lock<std::mutex> lock(job->chunksMutex);
+        job->pendingChunks.emplace_back();
+        job->pendingChunks.back().swap(tc->intermediateVec);
+    }
+    job->chunksReady.notify_one();
+    if (!last) {
+        tc->intermediateVec.reserve(job->chunkThreshold);
+    }
+}
+
+/**
+ * @brief Sorts and combines one chunk on the calling thread.
+ *
+ * The chunk is swapped in as the thread's buffer, so combine's emit2
+ * output lands in it, exactly as for a whole run.
+ */
+static void sortChunk(ThreadContext* tc, IntermediateVec& chunk) {
+    IntermediateVec saved;
+    saved.swap(tc->intermediateVec);
+    tc->intermediateVec.swap(chunk);
+    sortAndCombine(tc);
+    chunk.swap(tc->intermediateVec);
+    tc->intermediateVec.swap(saved);
+}
+
+/**
+ * @brief Sort phase of a chunked job: sorts pending chunks until every thread has mapped.
+ *
+ * A thread that finishes mapping (and has published its last partial
+ * chunk) sorts whichever chunks are pending, including those a slower thread is
+ * still publishing, so the sort work is shared instead of trailing the
+ * last mapper. Each sorted chunk becomes one run of the shuffle.
+ */
+static void sortChunks(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    std::unique_lock<std::mutex> lock(job->chunksMutex);
+    if (--job->mappingThreads == 0) {
+        job->chunksReady.notify_all();
+    }
+    while (true) {
+        job->chunksReady.wait(lock, [job] {
+            return !job->pendingChunks.empty() || job->mappingThreads == 0;
+        });
+        if (job->pendingChunks.empty()) break;
+        IntermediateVec chunk;
+        chunk.swap(job->pendingChunks.back());
+        job->pendingChunks.pop_back();
+        lock.unlock();
+        if (!skipSorting(job)) {
+            sortChunk(tc, chunk);
+        }
+        lock.lock();
+        job->sortedChunks.push_back(std::move(chunk));
+    }
+}
+
+/**
+ * @brief Returns every sorted in-memory run: each thread's buffer, then each sorted chunk.
+ */
+static std::vector<const IntermediateVec*> inMemoryRuns(JobContext* job) {
+    std::vector<const IntermediateVec*> runs;
+    runs.reserve(job->threadCount + job->sortedChunks.size());
+    for (const ThreadContext& tc : job->threadContexts) {
+        runs.push_back(&tc.intermediateVec);
+    }
+    for (const IntermediateVec& chunk : job->sortedChunks) {
+        runs.push_back(&chunk);
+    }
+    return runs;
+}
+
+// ======================[ Spilling ]================================
+
+/**
+ * @brief Writes the thread's buffer to disk as one sorted run and empties it.
+ */
+static void spillIntermediate(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    const IntermediateSerializer* serializer = job->options.serializer;
+    sortAndCombine(tc);
+
+    std::unique_ptr<SpillFile> spill(new SpillFile(job->options.spillDirectory));
+    std::string record;
+    for (const IntermediatePair& pair : tc->intermediateVec) {
+        record.clear();
+        serializer->serialize(pair.first, pair.second, record);
+        spill->append(record);
+        serializer->release(pair.first, pair.second);
+    }
+    spill->rewind();
+    tc->spills.push_back(std::move(spill));
+    tc->intermediateVec.clear();
+}
+
+// ======================[ Map Cache ]===============================
+
+/**
+ * @brief Maps one partition on its own, caches its sorted run and keeps its pairs.
+ *
+ * The partition is mapped into an empty buffer so it can be sorted and
+ * combined alone. The sorted run is then kept as one of the job's sorted
+ * chunks, which the shuffle merges like any other run, so it is never
+ * sorted again.
+ */
+static void mapPartition(ThreadContext* tc, size_t partition, size_t firstChunk, size_t chunks,
+                         uint64_t fingerprint) {
+    JobContext* job = tc->job;
+    const IntermediateSerializer* serializer = job->options.serializer;
+    MapCache& cache = *job->options.mapCache;
+    IntermediateVec run;
+    run.swap(tc->intermediateVec);
+    for (size_t chunk = firstChunk; chunk < firstChunk + chunks; ++chunk) {
+        job->input->mapChunk(chunk, *job->client, tc);
+        addProgress(tc, 1);
+    }
+    sortAndCombine(tc);
+
+    std::unique_ptr<SpillFile> cached(new SpillFile(cache.directory()));
+    std::string record;
+    for (const IntermediatePair& pair : tc->intermediateVec) {
+        record.clear();
+        serializer->serialize(pair.first, pair.second, record);
+        cached->append(record);
+    }
+    cached->rewind();
+    cache.store(partition, fingerprint, std::move(cached));
+
+    if (job->options.collectStats) {
+        tc->stats.intermediateBytes += tc->intermediateVec.size() * sizeof(IntermediatePair);
+    }
+    {
+        std::lock_guard<std::mutex> lock(job->chunksMutex);
+        job->sortedChunks.emplace_back();
+        job->sortedChunks.back().swap(tc->intermediateVec);
+    }
+    tc->intermediateVec.swap(run);
+}
+
+/**
+ * @brief Map phase of a mapCache job: claims whole partitions, reusing unchanged ones.
+ */
+static void mapThroughCache(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    MapCache& cache = *job->options.mapCache;
+    size_t span = cache.chunksPerPartition();
+    size_t first, count;
+    while (!checkCancelled(job) && claimBatch(job, job->cachePartitions, &first, &count)) {
+        for (size_t partition = first; partition < first + count; ++partition) {
+            size_t firstChunk = partition * span;
+            size_t chunks = std::min(span, job->chunkCount - firstChunk);
+            uint64_t fingerprint = job->options.partitionFingerprint(firstChunk, chunks,
+                                                                     job->options.callbackData);
+            if (cache.reuse(partition, fingerprint)) {
+                addProgress(tc, chunks);
+            } else {
+                mapPartition(tc, partition, firstChunk, chunks, fingerprint);
+            }
+        }
+    }
+}
+
+// ======================[ Shuffle Stage ]===========================
+
+/**
+ * @brief Receives each finished key group produced by the shuffle.
+ */
+typedef std::function<void(IntermediateVec&)> GroupHandler;
+
+
+/**
+ * @brief Takes the next pair of a slice; returns false once it is exhausted.
+ */
+static bool nextPair(JobContext* job, RunSlice& slice, std::string& record,
+                     IntermediatePair& pair) {
+    if (slice.spill != nullptr) {
+        if (!slice.spill->next(record)) return false;
+        pair = job->options.serializer->deserialize(record.data(), record.size());
+        return true;
+    }
+    if (slice.begin == slice.end) return false;
+    pair = *slice.begin++;
+    return true;
+}
+
+/**
+ * @brief Returns true if the two keys are equivalent under K2::operator<.
+ */
+static bool sameKey(const K2* a, const K2* b) {
+    return !(*a < *b) && !(*b < *a);
+}
+
+/**
+ * @brief Stores the shuffle stage state once the number of pairs is known.
+ */
+static void beginShuffleStage(JobContext* job) {
+    uint64_t totalPairs = 0;
+    if (job->options.mapCache != nullptr) {
+        job->options.mapCache->reusedRuns(&job->cachedRuns);
+        for (const SpillFile* run : job->cachedRuns) {
+            totalPairs += run->records();
+        }
+    }
+    try {
+        for (const IntermediateVec* run : inMemoryRuns(job)) {
+            totalPairs += run->size();
+        }
+        for (ThreadContext& tc : job->threadContexts) {
+            for (const std::unique_ptr<SpillFile>& spill : tc.spills) {
+                totalPairs += spill->records();
+            }
+        }
+        setStage(job, SHUFFLE_STAGE, totalPairs);
+    } catch (const std::exception& e) {
+        SYSTEM_ERROR_MSG("failed during shuffle stage: " << e.what());
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+}
+
+/**
+ * @brief Called after each group the merge adds to a GroupBuffer.
+ */
+typedef std::function<void(GroupBuffer&)> GroupEndHandler;
+
+/**
+ * @brief K-way merges sorted slices into out, one group per key.
+ *
+ * A loser tree over the slices' cached head pairs picks each next pair in
+ * about log2(k) key comparisons. Heads come out in order, so the next pair
+ * starts a new group exactly when the group's key is less than its key:
+ * one comparison per pair. The buffer is reserved for every pair up front,
+ * so the merge copies each pair once and allocates nothing per group.
+ * onGroupEnd, if set, runs after every group and may move the finished
+ * groups out of the buffer.
+ */
+static void mergeRunSlices(ThreadContext* tc, std::vector<RunSlice>& slices, GroupBuffer& out,
+                           const GroupEndHandler& onGroupEnd = nullptr) {
+    JobContext* job = tc->job;
+    if (slices.empty()) return;
+    std::string record;
+    std::vector<IntermediatePair> heads(slices.size());
+    std::vector<char> live(slices.size());
+    for (size_t i = 0; i < slices.size(); ++i) {
+        live[i] = nextPair(job, slices[i], record, heads[i]);
+    }
+    auto headLess = [&heads, &live](int a, int b) {
+        return live[a] && (!live[b] || *heads[a].first < *heads[b].first);
+    };
+    LoserTree<decltype(headLess)> tree(static_cast<int>(slices.size()), headLess);
+
+    if (!onGroupEnd) {
+        size_t pairs = 0;
+        for (const RunSlice& slice : slices) {
+            pairs += slice.spill ? slice.spill->records() : slice.end - slice.begin;
+        }
+        out.pairs.reserve(out.pairs.size() + pairs);
+    }
+
+    while (live[tree.top()]) {
+        size_t groupBegin = out.pairs.size();
+        if (pollCancelled(tc)) {
+            // Cancelled: the rest becomes one last group, to be discarded unmerged.
+            // Records still on disk were never deserialized and need no release.
+            for (size_t i = 0; i < slices.size(); ++i) {
+                if (!live[i]) continue;
+                out.pairs.push_back(heads[i]);
+                if (slices[i].spill == nullptr) {
+                    out.pairs.insert(out.pairs.end(), slices[i].begin, slices[i].end);
+                }
+            }
+            addProgress(tc, out.pairs.size() - groupBegin);
+            out.endGroup();
+            if (onGroupEnd) {
+                onGroupEnd(out);
+            }
+            return;
+        }
+        const K2* groupKey = heads[tree.top()].first;
+        do {
+            int i = tree.top();
+            out.pairs.push_back(heads[i]);
+            live[i] = nextPair(job, slices[i], record, heads[i]);
+            tree.replay();
+        } while (live[tree.top()] && !(*groupKey < *heads[tree.top()].first));
+
+        addProgress(tc, out.pairs.size() - groupBegin); // Update processed count
+        out.endGroup();
+        if (onGroupEnd) {
+            onGroupEnd(out);
+        }
+    }
+}
+
+/**
+ * @brief Indexes the groups of every shuffle buffer, in buffer order.
+ */
+static void indexShuffledGroups(JobContext* job) {
+    size_t totalGroups = 0;
+    for (const GroupBuffer& buffer : job->shuffleBuffers) {
+        totalGroups += buffer.groups();
+    }
+    job->shuffledGroups.reserve(totalGroups);
+    for (size_t b = 0; b < job->shuffleBuffers.size(); ++b) {
+        const GroupBuffer& buffer = job->shuffleBuffers[b];
+        for (size_t i = 0; i < buffer.groups(); ++i) {
+            job->shuffledGroups.push_back({buffer.pairs.data() + buffer.offsets[i],
+                                           buffer.offsets[i + 1] - buffer.offsets[i], b});
+        }
+    }
+}
+
+/**
+ * @brief Merges every thread's whole sorted run into out.
+ */
+static void shuffleAllRuns(ThreadContext* caller, GroupBuffer& out,
+                           const GroupEndHandler& onGroupEnd = nullptr) {
+    JobContext* job = caller->job;
+    std::vector<RunSlice> slices;
+    slices.reserve(job->threadCount + job->sortedChunks.size());
+    for (const IntermediateVec* run : inMemoryRuns(job)) {
+        slices.push_back({run->data(), run->data() + run->size(), nullptr});
+    }
+    for (ThreadContext& tc : job->threadContexts) {
+        for (const std::unique_ptr<SpillFile>& spill : tc.spills) {
+            slices.push_back({nullptr, nullptr, spill.get()});
+        }
+    }
+    for (SpillFile* run : job->cachedRuns) {
+        slices.push_back({nullptr, nullptr, run});
+    }
+    mergeRunSlices(caller, slices, out, onGroupEnd);
+    for (ThreadContext& tc : job->threadContexts) {
+        tc.spills.clear();
+    }
+}
+
+/**
+ * @brief Merges every run into one shuffle buffer and indexes its groups.
+ */
+static void shuffleIntoBuffer(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    job->shuffleBuffers.emplace_back();
+    shuffleAllRuns(tc, job->shuffleBuffers.back());
+    indexShuffledGroups(job);
+}
+
+/**
+ * @brief Performs the shuffle stage: groups all intermediate pairs by key.
+ */
+static void performShuffleStage(ThreadContext* tc) {
+    beginShuffleStage(tc->job);
+    shuffleIntoBuffer(tc);
+}
+
+/**
+ * @brief Cuts every sorted run into threadCount key ranges at sampled splitters.
+ *
+ * Called by thread 0 only, after every run is sorted. Range r of the parallel
+ * shuffle holds the keys in [splitter r - 1, splitter r). The bounds are
+ * resolved here, before any range is merged, because pipelined reducers may
+ * release the splitter keys as soon as the first groups are published.
+ */
+static void chooseSplitters(JobContext* job) {
+    std::vector<const IntermediateVec*> runs = inMemoryRuns(job);
+    std::vector<K2*> samples;
+    samples.reserve(runs.size() * SPLITTER_SAMPLES_PER_THREAD);
+    for (const IntermediateVec* run : runs) {
+        const IntermediateVec& vec = *run;
+        if (vec.empty()) continue;
+        size_t count = std::min<size_t>(vec.size(), SPLITTER_SAMPLES_PER_THREAD);
+        for (size_t i = 0; i < count; ++i) {
+            samples.push_back(vec[i * vec.size() / count].first);
+        }
+    }
+    std::sort(samples.begin(), samples.end(),
+              [](const K2* a, const K2* b) { return *a < *b; });
+
+    auto keyLess = [](const IntermediatePair& pair, const K2* key) {
+        return *(pair.first) < *key;
+    };
+    job->shuffleBuffers.resize(job->threadCount);
+    job->rangeSlices.assign(job->threadCount, std::vector<RunSlice>());
+    for (const IntermediateVec* run : runs) {
+        const IntermediatePair* lo = run->data();
+        const IntermediatePair* end = lo + run->size();
+        for (int r = 0; r < job->threadCount; ++r) {
+            const IntermediatePair* hi = end;
+            if (r + 1 < job->threadCount && !samples.empty()) {
+                K2* splitter = samples[(r + 1) * samples.size() / job->threadCount];
+                hi = std::lower_bound(lo, end, splitter, keyLess);
+            }
+            job->rangeSlices[r].push_back({lo, hi, nullptr});
+            lo = hi;
+        }
+    }
+}
+
+/**
+ * @brief Merges and groups the key range owned by the calling thread.
+ *
+ * The range's groups go to shuffleBuffers[threadID], which this thread
+ * allocates, so they stay on its NUMA node.
+ */
+static void shuffleKeyRange(ThreadContext* caller) {
+    JobContext* job = caller->job;
+    mergeRunSlices(caller, job->rangeSlices[caller->threadID],
+                   job->shuffleBuffers[caller->threadID]);
+}
+
+/**
+ * @brief Indexes the per-range groups in key order.
+ */
+static void collectKeyRanges(JobContext* job) {
+    indexShuffledGroups(job);
+    if (job->options.pinThreads) {
+        size_t offset = 0;
+        for (const GroupBuffer& buffer : job->shuffleBuffers) {
+            job->rangeOffsets.push_back(offset);
+            offset += buffer.groups();
+        }
+        job->rangeOffsets.push_back(offset);
+        job->rangeCursors.reset(new std::atomic<size_t>[job->threadCount]);
+        for (int r = 0; r < job->threadCount; ++r) {
+            job->rangeCursors[r].store(0);
+        }
+    }
+    job->rangeSlices.clear();
+}
+
+// ======================[ Distributed Shuffle ]=====================
+
+/**
+ * @brief Appends one length-prefixed record to a send buffer.
+ */
+static void appendFrame(std::string& buffer, const std::string& record) {
+    uint32_t length = htonl(static_cast<uint32_t>(record.size()));
+    buffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    buffer.append(record);
+}
+
+/**
+ * @brief Appends a FRAME_RUN_END or FRAME_STREAM_END marker to a send buffer.
+ */
+static void appendMarker(std::string& buffer, uint32_t marker) {
+    uint32_t header = htonl(marker);
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+/**
+ * @brief Reads the next frame from peer; returns its length or a marker.
+ */
+static uint32_t receiveFrame(PeerMesh& mesh, int peer, std::string& record) {
+    uint32_t header = 0;
+    mesh.receive(peer, reinterpret_cast<char*>(&header), sizeof(header));
+    uint32_t length = ntohl(header);
+    if (length == FRAME_RUN_END || length == FRAME_STREAM_END) return length;
+    record.resize(length);
+    if (length > 0) {
+        mesh.receive(peer, &record[0], length);
+    }
+    return length;
+}
+
+/**
+ * @brief Agrees on the nodes - 1 splitters, returned as serialized records.
+ *
+ * Every node sends up to SPLITTER_SAMPLES_PER_THREAD evenly spaced keys of
+ * each sorted in-memory run to rank 0, which sorts the union of the samples
+ * and sends back the evenly spaced ones as range bounds. Node r reduces the
+ * keys in [splitter r - 1, splitter r). Without samples there are no
+ * splitters and every key stays on rank 0.
+ */
+static std::vector<std::string> exchangeSplitters(JobContext* job) {
+    const IntermediateSerializer* serializer = job->options.serializer;
+    PeerMesh& mesh = *job->mesh;
+    std::vector<std::string> samples;
+    std::string record;
+    for (const ThreadContext& tc : job->threadContexts) {
+        const IntermediateVec& vec = tc.intermediateVec;
+        size_t count = std::min<size_t>(vec.size(), SPLITTER_SAMPLES_PER_THREAD);
+        for (size_t i = 0; i < count; ++i) {
+            const IntermediatePair& pair = vec[i * vec.size() / count];
+            record.clear();
+            serializer->serialize(pair.first, pair.second, record);
+            samples.push_back(record);
+        }
+    }
+
+    std::vector<std::string> splitters;
+    std::string buffer;
+    if (mesh.rank() != 0) {
+        for (const std::string& sample : samples) {
+            appendFrame(buffer, sample);
+        }
+        appendMarker(buffer, FRAME_RUN_END);
+        mesh.send(0, buffer.data(), buffer.size());
+        while (receiveFrame(mesh, 0, record) != FRAME_RUN_END) {
+            splitters.push_back(record);
+        }
+        return splitters;
+    }
+
+    for (int peer = 1; peer < mesh.size(); ++peer) {
+        while (receiveFrame(mesh, peer, record) != FRAME_RUN_END) {
+            samples.push_back(record);
+        }
+    }
+    std::vector<std::pair<IntermediatePair, size_t>> keyed; // (sample, index into samples)
+    keyed.reserve(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        keyed.emplace_back(serializer->deserialize(samples[i].data(), samples[i].size()), i);
+    }
+    std::sort(keyed.begin(), keyed.end(),
+              [](const std::pair<IntermediatePair, size_t>& a,
+                 const std::pair<IntermediatePair, size_t>& b) {
+                  return *a.first.first < *b.first.first;
+              });
+    if (!keyed.empty()) {
+        for (int r = 1; r < mesh.size(); ++r) {
+            splitters.push_back(samples[keyed[r * keyed.size() / mesh.size()].second]);
+        }
+    }
+    for (std::pair<IntermediatePair, size_t>& sample : keyed) {
+        serializer->release(sample.first.first, sample.first.second);
+    }
+
+    for (const std::string& splitter : splitters) {
+        appendFrame(buffer, splitter);
+    }
+    appendMarker(buffer, FRAME_RUN_END);
+    for (int peer = 1; peer < mesh.size(); ++peer) {
+        mesh.send(peer, buffer.data(), buffer.size());
+    }
+    return splitters;
+}
+
+/**
+ * @brief Writes every run a peer routes to this node into its own spill file.
+ */
+static void receiveRuns(JobContext* job, int peer,
+                        std::vector<std::unique_ptr<SpillFile>>* runs) {
+    std::string record;
+    std::unique_ptr<SpillFile> run;
+    uint32_t frame;
+    while ((frame = receiveFrame(*job->mesh, peer, record)) != FRAME_STREAM_END) {
+        if (frame == FRAME_RUN_END) {
+            if (run) {
+                run->rewind();
+                runs->push_back(std::move(run));
+            }
+            continue;
+        }
+        if (!run) {
+            run.reset(new SpillFile(job->options.spillDirectory));
+        }
+        run->append(record);
+    }
+}
+
+/**
+ * @brief Per-peer send buffers of the run exchange.
+ */
+struct RunRouter {
+    JobContext* job;
+    std::vector<K2*> bounds;               // Deserialized splitter keys
+    std::vector<std::string> buffers;      // Pending frames per peer
+
+    /**
+     * @brief Returns the node that reduces key.
+     */
+    int destination(const K2* key) const {
+        auto it = std::upper_bound(bounds.begin(), bounds.end(), key,
+                                   [](const K2* a, const K2* b) { return *a < *b; });
+        return static_cast<int>(it - bounds.begin());
+    }
+
+    void forward(int peer, const std::string& record) {
+        appendFrame(buffers[peer], record);
+        if (buffers[peer].size() >= CLUSTER_SEND_BUFFER_BYTES) {
+            flush(peer);
+        }
+    }
+
+    /**
+     * @brief Ends the current run on every peer.
+     */
+    void endRun() {
+        for (int peer = 0; peer < job->mesh->size(); ++peer) {
+            if (peer != job->mesh->rank()) {
+                appendMarker(buffers[peer], FRAME_RUN_END);
+            }
+        }
+    }
+
+    void flush(int peer) {
+        job->mesh->send(peer, buffers[peer].data(), buffers[peer].size());
+        buffers[peer].clear();
+    }
+};
+
+/**
+ * @brief Sends the pairs of tc's sorted runs that other nodes reduce.
+ *
+ * The in-memory run keeps its local pairs in place and releases the sent
+ * ones; a spilled run is streamed and replaced by a run of its local records.
+ */
+static void routeRuns(ThreadContext* caller, ThreadContext& tc, RunRouter& router) {
+    JobContext* job = caller->job;
+    const IntermediateSerializer* serializer = job->options.serializer;
+    int self = job->mesh->rank();
+    std::string record;
+
+    IntermediateVec kept;
+    for (const IntermediatePair& pair : tc.intermediateVec) {
+        int peer = router.destination(pair.first);
+        if (peer == self) {
+            kept.push_back(pair);
+            continue;
+        }
+        record.clear();
+        serializer->serialize(pair.first, pair.second, record);
+        router.forward(peer, record);
+        serializer->release(pair.first, pair.second);
+    }
+    router.endRun();
+    addProgress(caller, tc.intermediateVec.size());
+    tc.intermediateVec.swap(kept);
+
+    for (std::unique_ptr<SpillFile>& spill : tc.spills) {
+        std::unique_ptr<SpillFile> local;
+        while (spill->next(record)) {
+            IntermediatePair pair = serializer->deserialize(record.data(), record.size());
+            int peer = router.destination(pair.first);
+            serializer->release(pair.first, pair.second);
+            if (peer != self) {
+                router.forward(peer, record);
+                continue;
+            }
+            if (!local) {
+                local.reset(new SpillFile(job->options.spillDirectory));
+            }
+            local->append(record);
+        }
+        router.endRun();
+        addProgress(caller, spill->records());
+        if (local) {
+            local->rewind();
+        }
+        spill = std::move(local);
+    }
+    tc.spills.erase(std::remove(tc.spills.begin(), tc.spills.end(), nullptr), tc.spills.end());
+}
+
+/**
+ * @brief Distributed shuffle stage: exchanges runs by key range, then merges.
+ *
+ * Run by thread 0 while the other threads wait at the barrier. The stage
+ * total first counts each local pair twice (routing it, then merging it) and
+ * is corrected to the pairs actually merged once the exchange is over.
+ * One receiver thread per peer drains its connection while this thread
+ * sends, so no node blocks on a full socket.
+ */
+static void performDistributedShuffle(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    const IntermediateSerializer* serializer = job->options.serializer;
+    PeerMesh& mesh = *job->mesh;
+    uint64_t localPairs = 0;
+    for (const ThreadContext& context : job->threadContexts) {
+        localPairs += context.intermediateVec.size();
+        for (const std::unique_ptr<SpillFile>& spill : context.spills) {
+            localPairs += spill->records();
+        }
+    }
+    setStage(job, SHUFFLE_STAGE, 2 * localPairs);
+
+    mesh.connect();
+    std::vector<std::string> splitters = exchangeSplitters(job);
+    RunRouter router{job, {}, std::vector<std::string>(mesh.size())};
+    std::vector<IntermediatePair> bounds;
+    for (const std::string& splitter : splitters) {
+        bounds.push_back(serializer->deserialize(splitter.data(), splitter.size()));
+        router.bounds.push_back(bounds.back().first);
+    }
+
+    std::vector<std::vector<std::unique_ptr<SpillFile>>> received(mesh.size());
+    std::vector<std::thread> receivers;
+    try {
+        for (int peer = 0; peer < mesh.size(); ++peer) {
+            if (peer != mesh.rank()) {
+                receivers.emplace_back(receiveRuns, job, peer, &received[peer]);
+            }
+        }
+    } catch (const std::system_error& e) {
+        SYSTEM_ERROR_MSG("failed to create thread: " << e.what());
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+
+    for (ThreadContext& context : job->threadContexts) {
+        routeRuns(tc, context, router);
+    }
+    for (int peer = 0; peer < mesh.size(); ++peer) {
+        if (peer != mesh.rank()) {
+            appendMarker(router.buffers[peer], FRAME_STREAM_END);
+            router.flush(peer);
+        }
+    }
+    try {
+        for (std::thread& receiver : receivers) {
+            receiver.join();
+        }
+    } catch (const std::system_error& e) {
+        SYSTEM_ERROR_MSG("failed to join thread: " << e.what());
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    for (IntermediatePair& bound : bounds) {
+        serializer->release(bound.first, bound.second);
+    }
+
+    uint64_t mergePairs = 0;
+    for (ThreadContext& context : job->threadContexts) {
+        mergePairs += context.intermediateVec.size();
+        for (const std::unique_ptr<SpillFile>& spill : context.spills) {
+            mergePairs += spill->records();
+        }
+    }
+    std::vector<std::unique_ptr<SpillFile>>& spills = job->threadContexts[0].spills;
+    for (std::vector<std::unique_ptr<SpillFile>>& runs : received) {
+        for (std::unique_ptr<SpillFile>& run : runs) {
+            mergePairs += run->records();
+            spills.push_back(std::move(run));
+        }
+    }
+    publishStage(job, SHUFFLE_STAGE, localPairs + mergePairs, localPairs);
+    shuffleIntoBuffer(tc);
+}
+
+// ======================[ Hash Partitioning ]=======================
+
+/**
+ * @brief Adapts JobOptions::keyHash for std::unordered_map.
+ */
+struct KeyHasher {
+    KeyHashFn hash;
+    size_t operator()(const K2* key) const { return hash(key); }
+};
+
+/**
+ * @brief Adapts JobOptions::keyEqual (or K2::operator<) for std::unordered_map.
+ */
+struct KeyEquals {
+    KeyEqualFn equal;
+    bool operator()(const K2* a, const K2* b) const {
+        return equal ? equal(a, b) : sameKey(a, b);
+    }
+};
+
+/**
+ * @brief Groups the given hash buckets by key, in first-seen order.
+ *
+ * Groups are collected before any is handed to onGroup, so handlers may
+ * release the pairs (as reduce does) without invalidating the lookup table.
+ */
+static void groupBuckets(JobContext* job, const std::vector<IntermediateVec*>& buckets,
+                         const GroupHandler& onGroup) {
+    size_t pairs = 0;
+    for (const IntermediateVec* bucket : buckets) {
+        pairs += bucket->size();
+    }
+
+    std::vector<IntermediateVec> groups;
+    {
+        std::unordered_map<const K2*, size_t, KeyHasher, KeyEquals> groupOf(
+            pairs, KeyHasher{job->options.keyHash}, KeyEquals{job->options.keyEqual});
+        for (const IntermediateVec* bucket : buckets) {
+            for (const IntermediatePair& pair : *bucket) {
+                auto inserted = groupOf.emplace(pair.first, groups.size());
+                if (inserted.second) {
+                    groups.emplace_back();
+                }
+                groups[inserted.first->second].push_back(pair);
+            }
+        }
+    }
+    for (IntermediateVec& group : groups) {
+        onGroup(group);
+    }
+}
+
+/**
+ * @brief Runs the client's combiner over each repeated key of this thread's buckets.
+ */
+static void combineHashBuckets(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    for (IntermediateVec& bucket : tc->partitions) {
+        IntermediateVec pending;
+        pending.swap(bucket);
+        // Combined pairs hash back into the (now empty) bucket through emit2
+        groupBuckets(job, std::vector<IntermediateVec*>(1, &pending),
+                     [tc, &bucket](IntermediateVec& group) {
+            if (group.size() == 1) {
+                bucket.push_back(group[0]);
+            } else {
+                tc->job->client->combine(&group, tc);
+            }
+        });
+    }
+}
+
+/**
+ * @brief Groups and reduces hash partitions, each claimed by a single thread.
+ *
+ * Replaces the sort and shuffle: the job goes from MAP_STAGE straight to
+ * REDUCE_STAGE, whose progress counts reduced pairs.
+ */
+static void reduceHashPartitions(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    if (job->client->hasCombiner() && !checkCancelled(job)) {
+        combineHashBuckets(tc);
+    }
+    waitAtBarrier(tc); // Wait for all threads to finish map phase
+
+    if (tc->threadID == 0) {
+        uint64_t totalPairs = 0;
+        for (ThreadContext& other : job->threadContexts) {
+            for (const IntermediateVec& bucket : other.partitions) {
+                totalPairs += bucket.size();
+            }
+        }
+        setStage(job, REDUCE_STAGE, totalPairs);
+        job->vecIndex.store(0); // Reset for reduce phase
+    }
+    waitAtBarrier(tc);
+    if (tc->threadID >= job->reduceThreads) return;
+
+    std::vector<IntermediateVec*> buckets(job->threadCount);
+    while (true) {
+        size_t partition = job->vecIndex.fetch_add(1);
+        if (partition >= static_cast<size_t>(job->partitionCount)) break;
+
+        for (int i = 0; i < job->threadCount; ++i) {
+            buckets[i] = &(job->threadContexts[i].partitions[partition]);
+        }
+        groupBuckets(job, buckets, [tc, job](IntermediateVec& group) {
+            reduceGroup(tc, &group);
+            addProgress(tc, group.size());
+        });
+        for (IntermediateVec* bucket : buckets) {
+            IntermediateVec().swap(*bucket);
+        }
+    }
+}
+
+// ======================[ Inline Pairs ]============================
+
+/**
+ * @brief Merges every thread's sorted inline run into the job's flat buffer.
+ *
+ * Called by thread 0 only. Keys are plain integers, so the loser tree and
+ * the group boundary each compare two words instead of calling operator<.
+ */
+static void mergeInlineRuns(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    size_t totalPairs = 0;
+    for (const ThreadContext& other : job->threadContexts) {
+        totalPairs += other.inlineVec.size();
+    }
+    setStage(job, SHUFFLE_STAGE, totalPairs);
+
+    std::vector<size_t> heads(job->threadCount, 0);
+    auto headLess = [job, &heads](int a, int b) {
+        const std::vector<InlinePair>& runA = job->threadContexts[a].inlineVec;
+        const std::vector<InlinePair>& runB = job->threadContexts[b].inlineVec;
+        return heads[a] < runA.size() &&
+               (heads[b] == runB.size() || runA[heads[a]].key < runB[heads[b]].key);
+    };
+    LoserTree<decltype(headLess)> tree(job->threadCount, headLess);
+
+    std::vector<InlinePair>& out = job->inlinePairs;
+    out.reserve(totalPairs);
+    while (out.size() < totalPairs && !pollCancelled(tc)) {
+        size_t groupBegin = out.size();
+        job->inlineOffsets.push_back(groupBegin);
+        uint64_t key = job->threadContexts[tree.top()].inlineVec[heads[tree.top()]].key;
+        do {
+            int i = tree.top();
+            out.push_back(job->threadContexts[i].inlineVec[heads[i]++]);
+            tree.replay();
+        } while (out.size() < totalPairs &&
+                 job->threadContexts[tree.top()].inlineVec[heads[tree.top()]].key == key);
+        addProgress(tc, out.size() - groupBegin); // Update processed count
+    }
+    job->inlineOffsets.push_back(out.size());
+    for (ThreadContext& other : job->threadContexts) {
+        std::vector<InlinePair>().swap(other.inlineVec);
+    }
+}
+
+/**
+ * @brief Sorts, shuffles and reduces the inline pairs of an inlinePairs job.
+ *
+ * Replaces the pointer pipeline after the map phase: each thread radix-sorts
+ * its own run, thread 0 merges them, and all threads reduce the groups.
+ */
+static void reduceInlinePairs(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    size_t first, count;
+    switchPhase(tc, PHASE_SORT);
+    std::vector<InlinePair>& run = tc->inlineVec;
+    if (checkCancelled(job)) {
+        // Inline pairs need no release, so a cancelled job just drops them
+    } else if (run.size() < RADIX_SORT_MIN_PAIRS) {
+        std::stable_sort(run.begin(), run.end(), [](const InlinePair& a, const InlinePair& b) {
+            return a.key < b.key;
+        });
+    } else {
+        radixSortItems(run, [](const InlinePair& pair) { return pair.key; });
+    }
+    waitAtBarrier(tc); // Wait for all threads to finish map phase
+
+    switchPhase(tc, PHASE_SHUFFLE);
+    if (tc->threadID == 0) {
+        mergeInlineRuns(tc);
+        chooseReduceThreads(job, job->inlineOffsets.size() - 1);
+        setStage(job, REDUCE_STAGE, job->inlineOffsets.size() - 1);
+        job->vecIndex.store(0); // Reset for reduce phase
+    }
+    waitAtBarrier(tc);
+
+    switchPhase(tc, PHASE_REDUCE);
+    if (tc->threadID >= job->reduceThreads) return;
+    const std::vector<size_t>& offsets = job->inlineOffsets;
+    while (!checkCancelled(job) && claimBatch(job, offsets.size() - 1, &first, &count)) {
+        for (size_t index = first; index < first + count; ++index) {
+            size_t size = offsets[index + 1] - offsets[index];
+            recordGroupSize(tc, size);
+            job->client->reduceInline(job->inlinePairs.data() + offsets[index], size, tc);
+            addProgress(tc, 1);
+        }
+    }
+}
+
+// ======================[ Pipelined Reduce ]========================
+
+/**
+ * @brief Publishes the groups of a batch buffer and wakes reducers.
+ *
+ * The batch's contents move into a new shuffle buffer, which is never
+ * modified again, so reducers may read its groups without the lock. When
+ * lastBatch is set the calling shuffler retires; the last one to retire
+ * switches the job to REDUCE_STAGE, crediting the groups already reduced.
+ */
+static void publishGroups(JobContext* job, GroupBuffer& batch, bool lastBatch) {
+    {
+        std::unique_lock<std::mutex> lock(job->groupsMutex);
+        if (batch.groups() > 0) {
+            job->shuffleBuffers.emplace_back();
+            GroupBuffer& published = job->shuffleBuffers.back();
+            published.pairs.swap(batch.pairs);
+            published.offsets.swap(batch.offsets);
+            published.unreduced = published.groups();
+            batch.offsets.assign(1, 0);
+            size_t index = job->shuffleBuffers.size() - 1;
+            for (size_t i = 0; i < published.groups(); ++i) {
+                job->shuffledGroups.push_back({published.pairs.data() + published.offsets[i],
+                                               published.offsets[i + 1] - published.offsets[i],
+                                               index});
+            }
+        }
+        if (lastBatch && --job->activeShufflers == 0) {
+            setStage(job, REDUCE_STAGE, job->shuffledGroups.size(), job->reducedGroups);
+        }
+    }
+    job->groupsReady.notify_all();
+}
+
+/**
+ * @brief Shuffles the calling thread's share, publishing groups as they are produced.
+ */
+static void shuffleAndPublish(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    GroupBuffer batch;
+    GroupEndHandler publish = [job](GroupBuffer& groups) {
+        if (groups.pairs.size() >= PIPELINE_PUBLISH_PAIRS) {
+            publishGroups(job, groups, false);
+        }
+    };
+    if (job->options.shuffleMode == SHUFFLE_PARALLEL) {
+        mergeRunSlices(tc, job->rangeSlices[tc->threadID], batch, publish);
+    } else {
+        shuffleAllRuns(tc, batch, publish);
+    }
+    publishGroups(job, batch, true);
+}
+
+/**
+ * @brief Reduces published groups until every shuffler has retired.
+ *
+ * A published buffer is released once all of its groups are reduced, so
+ * groups do not outlive their reduce by more than one batch.
+ */
+static void reducePublishedGroups(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    bool reducedOne = false;
+    size_t reducedBuffer = 0;              // Buffer of the group reduced last
+
+    while (true) {
+        GroupSpan group;
+        {
+            std::unique_lock<std::mutex> lock(job->groupsMutex);
+            if (reducedOne) {
+                ++job->reducedGroups;
+                if (job->activeShufflers == 0) {
+                    addProgress(tc, 1);
+                }
+                GroupBuffer& buffer = job->shuffleBuffers[reducedBuffer];
+                if (--buffer.unreduced == 0) {
+                    IntermediateVec().swap(buffer.pairs);
+                }
+            }
+            job->groupsReady.wait(lock, [job] {
+                return job->nextGroup < job->shuffledGroups.size() ||
+                       job->activeShufflers == 0;
+            });
+            if (job->nextGroup >= job->shuffledGroups.size()) break;
+            group = job->shuffledGroups[job->nextGroup++];
+        }
+        reduceGroup(tc, group);
+        reducedOne = true;
+        reducedBuffer = group.buffer;
+    }
+}
+
+/**
+ * @brief Blocks until every shuffler has retired (threads left out of a pipelined reduce).
+ *
+ * The shufflers are still merging the caller's run, so its buffer must not
+ * be released or lent back to a runtime worker before they are done.
+ */
+static void awaitShuffleEnd(JobContext* job) {
+    std::unique_lock<std::mutex> lock(job->groupsMutex);
+    job->groupsReady.wait(lock, [job] { return job->activeShufflers == 0; });
+}
+
+// ======================[ Reduce Scheduling ]=======================
+
+/**
+ * @brief Measures the shuffled group sizes and flags the hot keys.
+ *
+ * Called by thread 0 once the shuffle is done. Combining runs before the
+ * shuffle, so these are the sizes the reducers actually see.
  */
-struct ThreadContext {
-    int threadID;
-    JobContext* job;
-    IntermediateVec intermediateVec;
+static void measureSkew(JobContext* job) {
+    SkewStats& skew = job->skew;
+    for (const GroupSpan& group : job->shuffledGroups) {
+        ++skew.groups;
+        skew.pairs += group.size;
+        skew.largestGroupPairs = std::max<uint64_t>(skew.largestGroupPairs, group.size);
+    }
+    if (skew.groups == 0) return;
+    job->hotKeyThreshold = std::max<size_t>(HOT_KEY_MIN_PAIRS - 1,
+                                            HOT_KEY_SKEW_FACTOR * skew.pairs / skew.groups);
+    for (const GroupSpan& group : job->shuffledGroups) {
+        if (group.size > job->hotKeyThreshold) {
+            ++skew.hotKeys;
+            skew.hotKeyPairs += group.size;
+        }
+    }
+}
 
-    ThreadContext(int id, JobContext* jobContext)
-        : threadID(id), job(jobContext), intermediateVec() {}
-};
+/**
+ * @brief Builds the reduce schedule for largest-first order and group splitting.
+ *
+ * Called by thread 0 once the shuffle is done. Groups larger than
+ * splitGroupPairs, and hot keys with splitHotKeys, become one task per
+ * slice (when the client has a combiner), scheduled first; the rest follow
+ * largest first or in key order. A hot key is cut into one slice per
+ * reduce thread, or into splitGroupPairs slices if those are smaller.
+ */
+static void planReduceTasks(JobContext* job) {
+    const std::vector<GroupSpan>& groups = job->shuffledGroups;
+    bool combiner = job->client->hasCombiner();
+    size_t splitSize = combiner ? job->options.splitGroupPairs : 0;
+    bool splitHot = combiner && job->options.splitHotKeys;
+
+    std::vector<size_t> order(groups.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    if (job->options.reduceOrder == REDUCE_LARGEST_FIRST) {
+        std::stable_sort(order.begin(), order.end(), [&groups](size_t a, size_t b) {
+            return groups[a].size > groups[b].size;
+        });
+    }
+
+    std::vector<ReduceTask> wholeGroups;
+    for (size_t group : order) {
+        size_t size = groups[group].size;
+        size_t sliceSize = (splitSize > 0 && size > splitSize) ? splitSize : 0;
+        if (splitHot && size > job->hotKeyThreshold) {
+            size_t hotSlice = (size + job->reduceThreads - 1) / job->reduceThreads;
+            if (sliceSize == 0 || hotSlice < sliceSize) {
+                sliceSize = hotSlice;
+            }
+        }
+        if (sliceSize == 0) {
+            wholeGroups.push_back({group, 0, size, -1});
+            continue;
+        }
+        int split = static_cast<int>(job->splitGroups.size());
+        size_t slices = (size + sliceSize - 1) / sliceSize;
+        job->splitGroups.emplace_back(new SplitGroup());
+        job->splitGroups.back()->sliceSize = sliceSize;
+        job->splitGroups.back()->partials.resize(slices);
+        job->splitGroups.back()->pending.store(slices);
+        for (size_t begin = 0; begin < size; begin += sliceSize) {
+            job->reduceTasks.push_back({group, begin, std::min(size, begin + sliceSize), split});
+        }
+    }
+    job->sliceTasks = job->reduceTasks.size();
+    job->reduceTasks.insert(job->reduceTasks.end(), wholeGroups.begin(), wholeGroups.end());
+}
 
 /**
- * @brief Context for the entire MapReduce job.
+ * @brief Combines one slice of a split group; the last slice reduces the group.
+ *
+ * The combiner's emit2 output is captured by swapping the thread's
+ * intermediate vector around the call.
  */
-struct JobContext {
-    const MapReduceClient* client;         // Client's map/reduce implementation
-    const InputVec* inputVec;              // Input vector for map phase
-    OutputVec* outputVec;                  // Final output vector (from reduce)
-    int threadCount;                       // Number of worker threads
-    std::vector<std::thread> threads;      // Thread objects
-    std::vector<ThreadContext> threadContexts; // Thread contexts
-    std::atomic<int> vecIndex;             // Index for work distribution
-    std::atomic<uint64_t> jobState;        // Encoded job state
-    Barrier barrier;                       // Barrier for thread synchronization
-    std::mutex outputMutex;                // Mutex for output vector
-    std::vector<IntermediateVec> shuffledVecsQueue; // Shuffled intermediate groups
-    bool calledWaitForJob;                 // Ensures waitForJob is called once
+static void runSliceTask(ThreadContext* tc, const ReduceTask& task) {
+    JobContext* job = tc->job;
+    SplitGroup& split = *job->splitGroups[task.split];
+    const GroupSpan& group = job->shuffledGroups[task.group];
+    size_t sliceIndex = task.begin / split.sliceSize;
 
-    JobContext(const MapReduceClient* client,
-               const InputVec* inputVec,
-               OutputVec* outputVec,
-               int threadCount)
-        : client(client),
-          inputVec(inputVec),
-          outputVec(outputVec),
-          threadCount(threadCount),
-          vecIndex(0),
-          jobState(0),
-          barrier(threadCount),
-          calledWaitForJob(false)
-    {
-        threadContexts.reserve(threadCount);
-        for (int i = 0; i < threadCount; ++i) {
-            threadContexts.emplace_back(i, this);
+    if (pollCancelled(tc)) {
+        discardPairs(tc, group.pairs + task.begin, task.end - task.begin);
+    } else {
+        IntermediateVec slice(group.pairs + task.begin, group.pairs + task.end);
+        IntermediateVec saved;
+        saved.swap(tc->intermediateVec);
+        tc->combining = true;
+        job->client->combine(&slice, tc);
+        tc->combining = false;
+        split.partials[sliceIndex].swap(tc->intermediateVec);
+        tc->intermediateVec.swap(saved);
+    }
+
+    if (split.pending.fetch_sub(1) == 1) {
+        IntermediateVec combined;
+        for (IntermediateVec& partial : split.partials) {
+            combined.insert(combined.end(), partial.begin(), partial.end());
+            IntermediateVec().swap(partial);
         }
+        reduceGroup(tc, &combined);
+        addProgress(tc, 1);
     }
-};
+}
+
+/**
+ * @brief Runs claimed reduce tasks until the schedule is exhausted.
+ *
+ * Slice tasks are claimed one at a time, so the slices of a split group
+ * spread over the threads instead of filling the first guided batch. The
+ * whole groups after them go in guided batches, or singly in largest-first
+ * order.
+ */
+static void runReduceTasks(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    bool largestFirst = job->options.reduceOrder == REDUCE_LARGEST_FIRST;
+    size_t first, count;
+    while (true) {
+        size_t maxBatch = (largestFirst || job->vecIndex.load() < job->sliceTasks) ? 1 :
+                          std::numeric_limits<size_t>::max();
+        if (!claimBatch(job, job->reduceTasks.size(), &first, &count, maxBatch)) break;
+        for (size_t index = first; index < first + count; ++index) {
+            const ReduceTask& task = job->reduceTasks[index];
+            if (task.split >= 0) {
+                runSliceTask(tc, task);
+            } else {
+                reduceGroup(tc, job->shuffledGroups[task.group]);
+                addProgress(tc, 1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Reduces the groups merged on the caller's node before any others.
+ *
+ * The groups of key range r were built by thread r during the parallel
+ * shuffle, so their buffers live on that thread's node. Each thread drains
+ * its own range, then the rest of its node's ranges, then the remote ones.
+ */
+static void reduceLocalRangesFirst(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    std::vector<int> order;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int k = 0; k < job->threadCount; ++k) {
+            int r = (tc->threadID + k) % job->threadCount;
+            bool local = job->threadContexts[r].node == tc->node;
+            if (local == (pass == 0)) {
+                order.push_back(r);
+            }
+        }
+    }
+    for (int r : order) {
+        size_t begin = job->rangeOffsets[r];
+        size_t count = job->rangeOffsets[r + 1] - begin;
+        size_t index;
+        while ((index = job->rangeCursors[r].fetch_add(1)) < count) {
+            reduceGroup(tc, job->shuffledGroups[begin + index]);
+            addProgress(tc, 1);
+        }
+    }
+}
 
-// ======================[ Utility Functions ]=======================
+// ======================[ Output Collection ]=======================
 
 /**
- * @brief Encodes the job state into a 64-bit integer.
+ * @brief Returns true if output a ranks below b for topK (outputLess or K3::operator<).
  */
-static uint64_t encodeJobState(int stage, uint64_t processed, uint64_t total) {
-    return (static_cast<uint64_t>(stage) << 62) | (processed << 31) | total;
+static bool outputRankLess(const JobContext* job, const OutputPair& a, const OutputPair& b) {
+    return job->options.outputLess ? job->options.outputLess(a, b) : *a.first < *b.first;
 }
 
-// ======================[ Shuffle Stage ]===========================
+/**
+ * @brief Offers an emitted pair to the thread's top-K heap, releasing whichever loses.
+ *
+ * The thread's output vector is a heap whose front is its smallest kept
+ * pair, so a pair that does not beat it is released without a heap update.
+ */
+static void keepTopK(ThreadContext* tc, K3* key, V3* value) {
+    JobContext* job = tc->job;
+    OutputVec& heap = tc->outputVec;
+    OutputPair pair(key, value);
+    auto greater = [job](const OutputPair& a, const OutputPair& b) {
+        return outputRankLess(job, b, a);
+    };
+    if (heap.size() == job->options.topK) {
+        if (!outputRankLess(job, heap.front(), pair)) {
+            job->client->releaseOutput(key, value);
+            return;
+        }
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        job->client->releaseOutput(heap.back().first, heap.back().second);
+        heap.back() = pair;
+    } else {
+        heap.push_back(pair);
+    }
+    std::push_heap(heap.begin(), heap.end(), greater);
+}
 
 /**
- * @brief Performs the shuffle stage: groups all intermediate pairs by key.
+ * @brief Merges the threads' top-K heaps and appends the topK largest pairs, largest first.
  */
-static void performShuffleStage(JobContext* job) {
-    uint64_t totalPairs = 0;
-    try {
+static void collectTopK(JobContext* job) {
+    OutputVec candidates;
+    for (ThreadContext& tc : job->threadContexts) {
+        candidates.insert(candidates.end(), tc.outputVec.begin(), tc.outputVec.end());
+        OutputVec().swap(tc.outputVec);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [job](const OutputPair& a, const OutputPair& b) { return outputRankLess(job, b, a); });
+    size_t kept = std::min(candidates.size(), job->options.topK);
+    for (size_t i = kept; i < candidates.size(); ++i) {
+        job->client->releaseOutput(candidates[i].first, candidates[i].second);
+    }
+    job->outputVec->insert(job->outputVec->end(), candidates.begin(), candidates.begin() + kept);
+}
+
+/**
+ * @brief Moves every thread's output buffer into the job's output vector.
+ *
+ * Run once, by the last thread to finish. Buffers are appended in thread
+ * order, or k-way merged by K3::operator< when sortedOutput is set.
+ */
+static void collectOutput(JobContext* job) {
+    if (job->options.topK > 0) {
+        collectTopK(job);
+        return;
+    }
+    size_t totalPairs = job->outputVec->size();
+    for (ThreadContext& tc : job->threadContexts) {
+        totalPairs += tc.outputVec.size();
+    }
+    job->outputVec->reserve(totalPairs);
+
+    if (!job->options.sortedOutput) {
         for (ThreadContext& tc : job->threadContexts) {
-            totalPairs += tc.intermediateVec.size();
+            job->outputVec->insert(job->outputVec->end(), tc.outputVec.begin(), tc.outputVec.end());
+            OutputVec().swap(tc.outputVec);
         }
-        job->jobState.store(encodeJobState(SHUFFLE_STAGE, 0, totalPairs));
-    } catch (const std::exception& e) {
-        SYSTEM_ERROR_MSG("failed during shuffle stage: " << e.what());
-        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        return;
     }
 
-    using PQElement = std::tuple<K2*, V2*, int>; // (key, value, threadIndex)
-    auto comp = [](const PQElement& a, const PQElement& b) {
-        return *(std::get<0>(b)) < *(std::get<0>(a)); // Min-heap by key
+    auto keyLess = [](const OutputPair& a, const OutputPair& b) { return *a.first < *b.first; };
+    std::vector<size_t> heads(job->threadCount, 0);
+    for (ThreadContext& tc : job->threadContexts) {
+        OutputVec& vec = tc.outputVec;
+        if (!std::is_sorted(vec.begin(), vec.end(), keyLess)) {
+            std::stable_sort(vec.begin(), vec.end(), keyLess);
+        }
+    }
+    auto headLess = [job, &heads, &keyLess](int a, int b) {
+        const OutputVec& vecA = job->threadContexts[a].outputVec;
+        const OutputVec& vecB = job->threadContexts[b].outputVec;
+        return heads[a] < vecA.size() &&
+               (heads[b] == vecB.size() || keyLess(vecA[heads[a]], vecB[heads[b]]));
     };
+    LoserTree<decltype(headLess)> tree(job->threadCount, headLess);
+    while (true) {
+        int i = tree.top();
+        OutputVec& vec = job->threadContexts[i].outputVec;
+        if (heads[i] == vec.size()) break;
+        job->outputVec->push_back(vec[heads[i]++]);
+        tree.replay();
+    }
+    for (ThreadContext& tc : job->threadContexts) {
+        OutputVec().swap(tc.outputVec);
+    }
+}
 
-    std::priority_queue<PQElement, std::vector<PQElement>, decltype(comp)> pq(comp);
-    std::vector<size_t> indices(job->threadCount, 0);
+// ======================[ Thread Main Function ]====================
 
-    // Initialize heap with first element from each thread's intermediate vector
-    for (int i = 0; i < job->threadCount; ++i) {
-        if (!job->threadContexts[i].intermediateVec.empty()) {
-            auto& vec = job->threadContexts[i].intermediateVec;
-            pq.emplace(vec[0].first, vec[0].second, i);
-            indices[i] = 1;
-        }
-    }
-
-    while (!pq.empty()) {
-        K2* currKey = std::get<0>(pq.top());
-        IntermediateVec group;
-
-        while (!pq.empty() &&
-               !(*currKey < *std::get<0>(pq.top())) &&
-               !(*std::get<0>(pq.top()) < *currKey)) {
-            K2* key = std::get<0>(pq.top());
-            V2* val = std::get<1>(pq.top());
-            int i = std::get<2>(pq.top());
-            pq.pop();
-            group.emplace_back(key, val);
-
-            if (indices[i] < job->threadContexts[i].intermediateVec.size()) {
-                auto& vec = job->threadContexts[i].intermediateVec;
-                pq.emplace(vec[indices[i]].first, vec[indices[i]].second, i);
-                ++indices[i];
-            }
-            job->jobState.fetch_add(1ULL << 31); // Update processed count
+/**
+ * @brief Returns true if the calling thread maps; with autoThreads, thread 0 decides first.
+ *
+ * Thread 0 maps the first AUTO_PROBE_CHUNKS chunks alone and times them. The
+ * map phase then gets one thread per AUTO_MAP_NANOS_PER_THREAD of estimated
+ * remaining work, so cheap inputs are not split across threads that cost
+ * more to wake and merge than they save. The others wait for the decision;
+ * those left out go straight to sorting and the barrier. A job cancelled
+ * during the probe stops it and maps on one thread, which stops too. The
+ * probe reads the deadline before every chunk: it times them anyway.
+ */
+static bool joinMapPhase(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    if (tc->threadID == 0 && !job->mapThreadsDecided) {
+        size_t probe = std::min<size_t>(job->chunkCount, AUTO_PROBE_CHUNKS);
+        job->vecIndex.store(probe);
+        uint64_t start = wallNanos();
+        size_t mapped = 0;
+        while (mapped < probe && !checkCancelled(job)) {
+            job->input->mapChunk(mapped++, *job->client, tc);
+            addProgress(tc, 1);
         }
-        job->shuffledVecsQueue.push_back(std::move(group));
+        uint64_t perChunk = (wallNanos() - start) / std::max<size_t>(mapped, 1);
+        uint64_t remaining = perChunk * (job->chunkCount - probe);
+        uint64_t wanted = mapped < probe ? 1 : 1 + remaining / AUTO_MAP_NANOS_PER_THREAD;
+        {
+            std::lock_guard<std::mutex> lock(job->threadsMutex);
+            job->mapThreads = static_cast<int>(std::min<uint64_t>(wanted, job->mapThreads));
+            job->mapThreadsDecided = true;
+        }
+        job->threadsDecided.notify_all();
+        return true;
+    }
+    if (job->options.autoThreads) {
+        std::unique_lock<std::mutex> lock(job->threadsMutex);
+        job->threadsDecided.wait(lock, [job] { return job->mapThreadsDecided; });
     }
+    return tc->threadID < job->mapThreads;
 }
 
-// ======================[ Thread Main Function ]====================
-
 /**
- * @brief Main function executed by each worker thread.
+ * @brief Runs every stage of the job on the calling worker thread.
  */
-static void runMapReduceJob(ThreadContext* tc) {
+static void runJobStages(ThreadContext* tc) {
     int threadId = tc->threadID;
     JobContext* job = tc->job;
-    size_t index;
+    size_t first, count;
 
     // Map phase
-    while (true) {
-        index = job->vecIndex.fetch_add(1);
-        if (index >= job->inputVec->size()) break;
+    if (!joinMapPhase(tc)) {
+        // Left out of the map phase: only sorts (chunks) and waits
+    } else if (job->options.mapCache != nullptr) {
+        mapThroughCache(tc);
+    } else {
+        while (!checkCancelled(job) && claimBatch(job, job->chunkCount, &first, &count)) {
+            for (size_t index = first; index < first + count && !pollCancelled(tc); ++index) {
+                job->input->mapChunk(index, *job->client, tc);
+                addProgress(tc, 1); // Update processed count
+            }
+        }
+    }
+    bool chunked = job->chunkThreshold != std::numeric_limits<size_t>::max();
+    if (chunked && !tc->intermediateVec.empty()) {
+        publishChunk(tc, true); // Hand off the last partial chunk too
+    }
+    recordIntermediateBytes(tc);
 
-        const K1* key = (*(job->inputVec))[index].first;
-        const V1* value = (*(job->inputVec))[index].second;
-        job->client->map(key, value, tc);
+    if (job->options.inlinePairs) {
+        reduceInlinePairs(tc);
+        return;
+    }
+    if (job->options.shuffleMode == SHUFFLE_HASH) {
+        switchPhase(tc, PHASE_REDUCE);
+        reduceHashPartitions(tc);
+        return;
+    }
 
-        job->jobState.fetch_add(1ULL << 31); // Update processed count
+    // Sort (and combine) intermediate vector by key
+    switchPhase(tc, PHASE_SORT);
+    if (chunked) {
+        sortChunks(tc);
+    } else if (!skipSorting(job) && job->options.mapCache == nullptr) {
+        sortAndCombine(tc); // mapCache partitions were sorted as they were mapped
     }
 
-    // Sort intermediate vector by key
-    std::sort(tc->intermediateVec.begin(), tc->intermediateVec.end(),
-              [](const IntermediatePair& a, const IntermediatePair& b) {
-                  return *(a.first) < *(b.first);
-              });
+    waitAtBarrier(tc); // Wait for all threads to finish map phase
+    switchPhase(tc, PHASE_SHUFFLE);
 
-    job->barrier.barrier(); // Wait for all threads to finish map phase
+    if (job->options.pipelineReduce) {
+        // Shuffle and reduce overlap: shufflers publish, every thread reduces
+        if (job->options.shuffleMode == SHUFFLE_PARALLEL) {
+            if (threadId == 0) {
+                beginShuffleStage(job);
+                chooseSplitters(job);
+            }
+            waitAtBarrier(tc);
+            shuffleAndPublish(tc);
+        } else if (threadId == 0) {
+            beginShuffleStage(job);
+            shuffleAndPublish(tc);
+        }
+        switchPhase(tc, PHASE_REDUCE);
+        if (threadId < job->reduceThreads) {
+            reducePublishedGroups(tc);
+        } else {
+            awaitShuffleEnd(job);
+        }
+        return;
+    }
 
-    // Shuffle phase (only thread 0)
+    if (job->options.shuffleMode == SHUFFLE_PARALLEL) {
+        // Shuffle phase (every thread merges one key range)
+        if (threadId == 0) {
+            beginShuffleStage(job);
+            chooseSplitters(job);
+        }
+        waitAtBarrier(tc);
+        shuffleKeyRange(tc);
+        waitAtBarrier(tc);
+        if (threadId == 0) {
+            collectKeyRanges(job);
+        }
+    } else if (threadId == 0 && job->mesh) {
+        // Shuffle phase (thread 0 exchanges key ranges with the other nodes)
+        performDistributedShuffle(tc);
+    } else if (threadId == 0) {
+        // Shuffle phase (only thread 0)
+        performShuffleStage(tc);
+    }
     if (threadId == 0) {
-        performShuffleStage(job);
-        job->jobState.store(encodeJobState(REDUCE_STAGE, 0, job->shuffledVecsQueue.size()));
+        chooseReduceThreads(job, job->shuffledGroups.size());
+        if (job->options.collectStats || job->options.splitHotKeys) {
+            measureSkew(job);
+        }
+        if (job->options.reduceOrder == REDUCE_LARGEST_FIRST || job->options.splitGroupPairs > 0 ||
+            job->options.splitHotKeys) {
+            planReduceTasks(job);
+        }
+        setStage(job, REDUCE_STAGE, job->shuffledGroups.size());
         job->vecIndex.store(0); // Reset for reduce phase
     }
-    job->barrier.barrier();
+    waitAtBarrier(tc);
+    switchPhase(tc, PHASE_REDUCE);
+    if (threadId >= job->reduceThreads) return;
+
+    if (!job->reduceTasks.empty()) {
+        runReduceTasks(tc);
+        return;
+    }
+    if (!job->rangeOffsets.empty()) {
+        reduceLocalRangesFirst(tc);
+        return;
+    }
 
     // Reduce phase
+    while (claimBatch(job, job->shuffledGroups.size(), &first, &count)) {
+        for (size_t index = first; index < first + count; ++index) {
+            reduceGroup(tc, job->shuffledGroups[index]);
+            addProgress(tc, 1);
+        }
+    }
+}
+
+/**
+ * @brief Main function executed by each worker thread.
+ *
+ * The last thread to finish collects the output, runs onDone and signals
+ * waitForJob; after that no thread touches the job, which may be deleted.
+ */
+static void runMapReduceJob(ThreadContext* tc) {
+    JobContext* job = tc->job;
+    int threadCount = job->threadCount;
+    if (tc->cpu >= 0) {
+        pinCurrentThread(tc->cpu);              // Before any buffer is first touched
+    }
+    if (tc->recycled != nullptr) {
+        tc->intermediateVec.swap(*tc->recycled); // Start from the worker's spare capacity
+    }
+    switchPhase(tc, PHASE_MAP);
+    runJobStages(tc);
+    switchPhase(tc, PHASE_COUNT);
+    if (job->options.outputSink != nullptr) {
+        job->options.outputSink->finish(tc->threadID);
+    }
+    if (tc->recycled != nullptr) {
+        tc->intermediateVec.clear();            // No thread reads it past the shuffle
+        tc->intermediateVec.swap(*tc->recycled);
+        if (tc->cpu >= 0) {
+            unpinCurrentThread();               // The pool worker outlives this job
+        }
+    }
+    if (job->finishedThreads.fetch_add(1) + 1 == threadCount) {
+        collectOutput(job);
+        if (job->options.onDone != nullptr) {
+            job->options.onDone(job, job->options.callbackData);
+        }
+        std::lock_guard<std::mutex> lock(job->doneMutex);
+        job->done = true;
+        job->doneCv.notify_all();
+    }
+}
+
+// ======================[ Job Launch ]==============================
+
+/**
+ * @brief Opens the output sink and publishes the initial job state.
+ */
+static void beginJob(JobContext* job) {
+    job->startNanos = wallNanos();
+    if (job->options.deadlineMillis > 0) {
+        job->deadlineNanos = job->startNanos + job->options.deadlineMillis * 1000000ULL;
+    }
+    if (job->options.outputSink != nullptr) {
+        job->options.outputSink->open(job->threadCount);
+    }
+    setStage(job, MAP_STAGE, job->chunkCount);
+}
+
+/**
+ * @brief Publishes the initial job state and starts the worker threads.
+ */
+static JobHandle launchJob(JobContext* job) {
+    beginJob(job);
+
+    for (int i = 0; i < job->threadCount; ++i) {
+        try {
+            job->threads.emplace_back(runMapReduceJob, &(job->threadContexts[i]));
+        } catch (const std::system_error& e) {
+            SYSTEM_ERROR_MSG("failed to create thread: " << e.what());
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+    }
+    return job;
+}
+
+// ======================[ Runtime ]=================================
+
+/**
+ * @brief A pool of long-lived workers shared by the jobs submitted to it.
+ *
+ * Jobs are gang-scheduled in submission order: a job starts only once
+ * threadCount workers are idle, since its threads meet at barriers and must
+ * all run at once. Jobs that fit side by side run concurrently.
+ */
+struct RuntimeContext {
+    std::vector<std::thread> workers;      // Pool threads
+    std::mutex mutex;                      // Guards every field below
+    std::condition_variable tasksReady;    // Signals new tasks or shutdown
+    std::deque<JobContext*> pendingJobs;   // Submitted jobs waiting for workers
+    std::deque<ThreadContext*> readyTasks; // Threads of dispatched jobs, not yet picked up
+    int idleWorkers;                       // Workers waiting for a task
+    bool stopping;                         // Set by closeRuntime
+
+    RuntimeContext() : idleWorkers(0), stopping(false) {}
+};
+
+/**
+ * @brief Hands queued jobs to idle workers while the oldest one fits.
+ *
+ * Called with runtime->mutex held.
+ */
+static void dispatchPendingJobs(RuntimeContext* runtime) {
+    while (!runtime->pendingJobs.empty()) {
+        JobContext* job = runtime->pendingJobs.front();
+        int freeWorkers = runtime->idleWorkers - static_cast<int>(runtime->readyTasks.size());
+        if (job->threadCount > freeWorkers) {
+            return;
+        }
+        runtime->pendingJobs.pop_front();
+        for (ThreadContext& tc : job->threadContexts) {
+            runtime->readyTasks.push_back(&tc);
+        }
+        runtime->tasksReady.notify_all();
+    }
+}
+
+/**
+ * @brief Main function of a pool worker: runs one job thread at a time.
+ */
+static void runRuntimeWorker(RuntimeContext* runtime) {
+    IntermediateVec spare; // Intermediate capacity carried from job to job
+    std::unique_lock<std::mutex> lock(runtime->mutex);
     while (true) {
-        index = job->vecIndex.fetch_add(1);
-        if (index >= job->shuffledVecsQueue.size()) break;
+        ++runtime->idleWorkers;
+        dispatchPendingJobs(runtime);
+        runtime->tasksReady.wait(lock, [runtime] {
+            return !runtime->readyTasks.empty() ||
+                   (runtime->stopping && runtime->pendingJobs.empty());
+        });
+        if (runtime->readyTasks.empty()) {
+            return;
+        }
+        ThreadContext* tc = runtime->readyTasks.front();
+        runtime->readyTasks.pop_front();
+        --runtime->idleWorkers;
+        lock.unlock();
 
-        const IntermediateVec* vec = &(job->shuffledVecsQueue[index]);
-        job->client->reduce(vec, tc);
-        job->jobState.fetch_add(1ULL << 31);
+        tc->recycled = &spare;
+        runMapReduceJob(tc);
+        lock.lock();
     }
 }
 
+/**
+ * @brief Publishes the initial job state and queues the job on the pool.
+ */
+static JobHandle submitJob(RuntimeContext* runtime, JobContext* job) {
+    beginJob(job);
+
+    std::lock_guard<std::mutex> lock(runtime->mutex);
+    runtime->pendingJobs.push_back(job);
+    dispatchPendingJobs(runtime);
+    return job;
+}
+
 // ======================[ API Functions ]===========================
 
 void waitForJob(JobHandle job) {
@@ -197,6 +2352,11 @@ void waitForJob(JobHandle job) {
             SYSTEM_ERROR_MSG("failed to join thread: " << e.what());
             EXIT_ON_ERROR(ERROR_EXIT_CODE);
         }
+        if (jobContext->threads.empty()) {
+            // Runtime job: the pool workers outlive it, so wait for its output
+            std::unique_lock<std::mutex> lock(jobContext->doneMutex);
+            jobContext->doneCv.wait(lock, [jobContext] { return jobContext->done; });
+        }
         jobContext->calledWaitForJob = true;
     }
 }
@@ -205,52 +2365,193 @@ JobHandle startMapReduceJob(const MapReduceClient& client,
                             const InputVec& inputVec,
                             OutputVec& outputVec,
                             int multiThreadLevel) {
-    JobContext* job = new JobContext(&client, &inputVec, &outputVec, multiThreadLevel);
-    uint64_t initState = encodeJobState(MAP_STAGE, 0, job->inputVec->size());
-    job->jobState.store(initState);
+    return startMapReduceJob(client, inputVec, outputVec, multiThreadLevel, JobOptions());
+}
+
+JobHandle startMapReduceJob(const MapReduceClient& client,
+                            const InputVec& inputVec,
+                            OutputVec& outputVec,
+                            int multiThreadLevel,
+                            const JobOptions& options) {
+    std::unique_ptr<InputSource> input(new VectorInputSource(inputVec));
+    JobContext* job = new JobContext(&client, input.get(), &outputVec, multiThreadLevel, options);
+    job->ownedInput = std::move(input);
+    return launchJob(job);
+}
+
+JobHandle startMapReduceJob(const MapReduceClient& client,
+                            const InputSource& input,
+                            OutputVec& outputVec,
+                            int multiThreadLevel) {
+    return startMapReduceJob(client, input, outputVec, multiThreadLevel, JobOptions());
+}
+
+JobHandle startMapReduceJob(const MapReduceClient& client,
+                            const InputSource& input,
+                            OutputVec& outputVec,
+                            int multiThreadLevel,
+                            const JobOptions& options) {
+    return launchJob(new JobContext(&client, &input, &outputVec, multiThreadLevel, options));
+}
 
-    for (int i = 0; i < multiThreadLevel; ++i) {
+RuntimeHandle createRuntime(int workerCount) {
+    RuntimeContext* runtime = new RuntimeContext();
+    for (int i = 0; i < workerCount; ++i) {
         try {
-            job->threads.emplace_back(runMapReduceJob, &(job->threadContexts[i]));
+            runtime->workers.emplace_back(runRuntimeWorker, runtime);
         } catch (const std::system_error& e) {
             SYSTEM_ERROR_MSG("failed to create thread: " << e.what());
             EXIT_ON_ERROR(ERROR_EXIT_CODE);
         }
     }
-    return job;
+    return runtime;
+}
+
+JobHandle startMapReduceJob(RuntimeHandle runtime,
+                            const MapReduceClient& client,
+                            const InputVec& inputVec,
+                            OutputVec& outputVec,
+                            int multiThreadLevel,
+                            const JobOptions& options) {
+    RuntimeContext* runtimeContext = static_cast<RuntimeContext*>(runtime);
+    int threadCount = std::min(multiThreadLevel, static_cast<int>(runtimeContext->workers.size()));
+    std::unique_ptr<InputSource> input(new VectorInputSource(inputVec));
+    JobContext* job = new JobContext(&client, input.get(), &outputVec, threadCount, options);
+    job->ownedInput = std::move(input);
+    return submitJob(runtimeContext, job);
+}
+
+JobHandle startMapReduceJob(RuntimeHandle runtime,
+                            const MapReduceClient& client,
+                            const InputSource& input,
+                            OutputVec& outputVec,
+                            int multiThreadLevel,
+                            const JobOptions& options) {
+    RuntimeContext* runtimeContext = static_cast<RuntimeContext*>(runtime);
+    int threadCount = std::min(multiThreadLevel, static_cast<int>(runtimeContext->workers.size()));
+    return submitJob(runtimeContext,
+                     new JobContext(&client, &input, &outputVec, threadCount, options));
+}
+
+void closeRuntime(RuntimeHandle runtime) {
+    RuntimeContext* runtimeContext = static_cast<RuntimeContext*>(runtime);
+    {
+        std::lock_guard<std::mutex> lock(runtimeContext->mutex);
+        runtimeContext->stopping = true;
+        runtimeContext->tasksReady.notify_all();
+    }
+    try {
+        for (std::thread& worker : runtimeContext->workers) {
+            worker.join();
+        }
+    } catch (const std::system_error& e) {
+        SYSTEM_ERROR_MSG("failed to join thread: " << e.what());
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    delete runtimeContext;
 }
 
+
 void emit2(K2* key, V2* value, void* context) {
     ThreadContext* tc = static_cast<ThreadContext*>(context);
-    tc->intermediateVec.emplace_back(key, value);
+    ++tc->stats.emit2Count;
+    if (tc->partitions.empty()) {
+        tc->intermediateVec.emplace_back(key, value);
+        if (tc->combining) return;
+        if (tc->intermediateVec.size() >= tc->job->spillThreshold) {
+            spillIntermediate(tc);
+        } else if (tc->intermediateVec.size() >= tc->job->chunkThreshold) {
+            publishChunk(tc);
+        }
+    } else {
+        size_t partition = tc->job->options.keyHash(key) % tc->partitions.size();
+        tc->partitions[partition].emplace_back(key, value);
+    }
 }
 
-void emit3(K3* key, V3* value, void* context) {
+void emitInline(uint64_t key, uint64_t value, void* context) {
+    ThreadContext* tc = static_cast<ThreadContext*>(context);
+    ++tc->stats.emit2Count;
+    tc->inlineVec.push_back({key, value});
+}
+
+void* allocIntermediate(size_t size, void* context) {
     ThreadContext* tc = static_cast<ThreadContext*>(context);
-    JobContext* job = tc->job;
     try {
-        std::unique_lock<std::mutex> lock(job->outputMutex);
-        job->outputVec->emplace_back(key, value);
-    } catch (const std::system_error& e) {
-        SYSTEM_ERROR_MSG("failed to lock mutex or add to output vector: " << e.what());
+        return tc->arena.allocate(size);
+    } catch (const std::bad_alloc& e) {
+        SYSTEM_ERROR_MSG("failed to allocate intermediate memory: " << e.what());
         EXIT_ON_ERROR(ERROR_EXIT_CODE);
     }
 }
 
+void emit3(K3* key, V3* value, void* context) {
+    ThreadContext* tc = static_cast<ThreadContext*>(context);
+    ++tc->stats.emit3Count;
+    if (tc->job->options.outputSink != nullptr) {
+        tc->job->options.outputSink->write(tc->threadID, key, value);
+        return;
+    }
+    if (tc->job->options.topK > 0) {
+        keepTopK(tc, key, value);
+        return;
+    }
+    tc->outputVec.emplace_back(key, value);
+}
+
+bool isJobDone(JobHandle job) {
+    JobContext* jobContext = static_cast<JobContext*>(job);
+    std::lock_guard<std::mutex> lock(jobContext->doneMutex);
+    return jobContext->done;
+}
+
+void cancelJob(JobHandle job) {
+    static_cast<JobContext*>(job)->cancelled.store(true);
+}
+
+bool isJobCancelled(JobHandle job) {
+    return static_cast<JobContext*>(job)->cancelled.load();
+}
+
 void getJobState(JobHandle job, JobState* state) {
     JobContext* jobContext = static_cast<JobContext*>(job);
-    uint64_t jobState;
+    uint64_t snapshot;
+    uint64_t total;
+    uint64_t processed;
     try {
-        jobState = jobContext->jobState.load();
+        // Retry until the stage is unchanged across the counter sum
+        do {
+            snapshot = jobContext->stageState.begin();
+            total = jobContext->stageState.total();
+            uint64_t tag = static_cast<uint64_t>(StageState::stageOf(snapshot));
+            processed = 0;
+            for (const ThreadContext& tc : jobContext->threadContexts) {
+                uint64_t value = tc.progress.load();
+                if ((value >> STAGE_TAG_SHIFT) == tag) {
+                    processed += value & PROGRESS_COUNT_MASK;
+                }
+            }
+        } while (!jobContext->stageState.validate(snapshot));
     } catch (const std::exception& e) {
         SYSTEM_ERROR_MSG("failed to load atomic job state: " << e.what());
         EXIT_ON_ERROR(ERROR_EXIT_CODE);
     }
-    // Decode jobState
-    state->stage = static_cast<stage_t>(jobState >> 62);
-    uint64_t total = jobState & 0x7FFFFFFF;
-    uint64_t processed = (jobState >> 31) & 0x7FFFFFFF;
-    state->percentage = (total == 0) ? 100.0f : (100.0f * processed / total);
+    fillJobState(snapshot, processed, total, state);
+}
+
+bool getJobStats(JobHandle job, JobStats* stats) {
+    JobContext* jobContext = static_cast<JobContext*>(job);
+    if (!jobContext->options.collectStats) {
+        return false;
+    }
+    stats->threads.clear();
+    for (const ThreadContext& tc : jobContext->threadContexts) {
+        stats->threads.push_back(tc.stats);
+    }
+    stats->skew = jobContext->skew;
+    stats->mapThreads = jobContext->mapThreads;
+    stats->reduceThreads = jobContext->reduceThreads;
+    return true;
 }
 
 void closeJobHandle(JobHandle job) {
@@ -2,10 +2,19 @@
 #define MAPREDUCEFRAMEWORK_H
 
 #include "MapReduceClient.h"
+#include "InputSource.h"
+#include "OutputSink.h"
+#include "JobStats.h"
+#include "PeerMesh.h"
+#include "MapCache.h"
+#include <cstddef>
+#include <new>
+#include <utility>
 
 // ======================[ Type Definitions ]========================
 
 typedef void* JobHandle;
+typedef void* RuntimeHandle;
 
 enum stage_t {
     UNDEFINED_STAGE = 0,
@@ -19,6 +28,91 @@ typedef struct {
     float percentage;
 } JobState;
 
+enum shuffle_mode_t {
+    SHUFFLE_SERIAL = 0,     // Thread 0 merges every thread's sorted run alone
+    SHUFFLE_PARALLEL = 1,   // Runs are cut into key ranges merged by all threads
+    SHUFFLE_HASH = 2        // Pairs are hash-partitioned and grouped unordered
+};
+
+enum reduce_order_t {
+    REDUCE_KEY_ORDER = 0,       // Groups are handed out in key order
+    REDUCE_LARGEST_FIRST = 1    // Groups are handed out by descending size
+};
+
+typedef void (*JobStageFn)(JobHandle job, stage_t stage, void* userData);
+typedef void (*JobDoneFn)(JobHandle job, void* userData);
+typedef size_t (*KeyHashFn)(const K2* key);
+typedef bool (*KeyEqualFn)(const K2* a, const K2* b);
+typedef bool (*OutputLessFn)(const OutputPair& a, const OutputPair& b);
+typedef uint64_t (*PartitionFingerprintFn)(size_t firstChunk, size_t chunkCount, void* userData);
+
+/**
+ * @brief Optional per-job settings. The defaults reproduce the classic pipeline.
+ */
+struct JobOptions {
+    shuffle_mode_t shuffleMode;    // How the sorted runs are grouped by key
+    bool pipelineReduce;           // Reduce groups while the shuffle still produces them
+    KeyHashFn keyHash;             // Required by SHUFFLE_HASH, which is ignored without it
+    KeyEqualFn keyEqual;           // SHUFFLE_HASH key equality; defaults to K2::operator<
+    size_t memoryBudget;           // Max in-memory intermediate pairs per job (0 = unlimited)
+    const IntermediateSerializer* serializer; // Required for memoryBudget, cluster and mapCache to take effect
+    const char* spillDirectory;    // Where sorted runs are spilled
+    size_t sortChunkPairs;         // Hand off a thread's buffer for sorting this often (0 = never)
+    bool sortedOutput;             // Merge the per-thread outputs by K3 instead of appending
+    size_t topK;                   // Keep only this many largest outputs (0 = keep all)
+    OutputLessFn outputLess;       // Ranks outputs for topK; defaults to K3::operator<
+    reduce_order_t reduceOrder;    // Order in which groups are handed to reducers
+    size_t splitGroupPairs;        // Split larger groups into combined slices (0 = never)
+    bool splitHotKeys;             // Split groups far above the mean size into combined slices
+    bool inlinePairs;              // Map emits InlinePairs (emitInline), reduced by reduceInline
+    int mapThreads;                // Threads that map (0 = all of multiThreadLevel)
+    int reduceThreads;             // Threads that reduce (0 = all of multiThreadLevel)
+    bool autoThreads;              // Size the map and reduce phases from measured work
+    bool pinThreads;               // Bind each thread to a CPU, spread node by node
+    unsigned barrierSpins;         // Polls before a barrier waiter sleeps (0 = mutex barrier)
+    JobStageFn onStage;            // Called as the job enters each stage
+    JobDoneFn onDone;              // Called once the output is complete
+    void* callbackData;            // Passed to onStage, onDone and partitionFingerprint
+    OutputSink* outputSink;        // Receives output as it is emitted (OutputVec unused)
+    bool collectStats;             // Record per-thread phase times and histograms
+    uint64_t deadlineMillis;       // Cancel the job this long after it starts (0 = never)
+    const ClusterSpec* cluster;    // Run as one node of a distributed job (ignored without serializer)
+    MapCache* mapCache;            // Reuse the sorted runs of unchanged input partitions
+    PartitionFingerprintFn partitionFingerprint; // Required by mapCache; gets callbackData
+
+    JobOptions()
+        : shuffleMode(SHUFFLE_SERIAL),
+          pipelineReduce(false),
+          keyHash(nullptr),
+          keyEqual(nullptr),
+          memoryBudget(0),
+          serializer(nullptr),
+          spillDirectory("/tmp"),
+          sortChunkPairs(0),
+          sortedOutput(false),
+          topK(0),
+          outputLess(nullptr),
+          reduceOrder(REDUCE_KEY_ORDER),
+          splitGroupPairs(0),
+          splitHotKeys(false),
+          inlinePairs(false),
+          mapThreads(0),
+          reduceThreads(0),
+          autoThreads(false),
+          pinThreads(false),
+          barrierSpins(0),
+          onStage(nullptr),
+          onDone(nullptr),
+          callbackData(nullptr),
+          outputSink(nullptr),
+          collectStats(false),
+          deadlineMillis(0),
+          cluster(nullptr),
+          mapCache(nullptr),
+          partitionFingerprint(nullptr)
+    { }
+};
+
 // ======================[ API Functions ]===========================
 
 /**
@@ -26,8 +120,48 @@ typedef struct {
  */
 void emit2(K2* key, V2* value, void* context);
 
+/**
+ * @brief Emits an inline intermediate pair from the map function (inlinePairs jobs).
+ *
+ * The key and value bits are copied into the thread's buffer, so nothing is
+ * allocated or released for the pair. Inline jobs must emit only this way.
+ */
+void emitInline(uint64_t key, uint64_t value, void* context);
+
+/**
+ * @brief Emits a trivially copyable key and value of at most 8 bytes each inline.
+ */
+template <typename K, typename V>
+void emitInline(const K& key, const V& value, void* context) {
+    emitInline(toInlineBits(key), toInlineBits(value), context);
+}
+
+/**
+ * @brief Allocates size bytes from the calling thread's job-owned arena.
+ *
+ * Valid inside map, combine and reduce. The memory is aligned for any type
+ * and is released in bulk by closeJobHandle; objects placed in it are never
+ * destroyed and must not be deleted by the client. Jobs that spill or may be
+ * cancelled must then override IntermediateSerializer::release and
+ * MapReduceClient::discard, whose defaults delete the pairs.
+ */
+void* allocIntermediate(size_t size, void* context);
+
+/**
+ * @brief Constructs a T in the calling thread's arena (see allocIntermediate).
+ */
+template <typename T, typename... Args>
+T* newIntermediate(void* context, Args&&... args) {
+    return new (allocIntermediate(sizeof(T), context)) T(std::forward<Args>(args)...);
+}
+
 /**
  * @brief Emits an output (K3, V3) pair from the reduce function.
+ *
+ * Pairs are buffered per thread and moved into the job's OutputVec when the
+ * last thread finishes, so the vector is complete once waitForJob returns.
+ * With JobOptions::outputSink set, each pair goes straight to the sink
+ * instead and sortedOutput has no effect.
  */
 void emit3(K3* key, V3* value, void* context);
 
@@ -39,16 +173,111 @@ JobHandle startMapReduceJob(const MapReduceClient& client,
                             OutputVec& outputVec,
                             int multiThreadLevel);
 
+/**
+ * @brief Starts a MapReduce job with explicit job options.
+ */
+JobHandle startMapReduceJob(const MapReduceClient& client,
+                            const InputVec& inputVec,
+                            OutputVec& outputVec,
+                            int multiThreadLevel,
+                            const JobOptions& options);
+
+/**
+ * @brief Starts a MapReduce job that streams its input from an InputSource.
+ */
+JobHandle startMapReduceJob(const MapReduceClient& client,
+                            const InputSource& input,
+                            OutputVec& outputVec,
+                            int multiThreadLevel);
+
+/**
+ * @brief Starts a MapReduce job over an InputSource with explicit job options.
+ */
+JobHandle startMapReduceJob(const MapReduceClient& client,
+                            const InputSource& input,
+                            OutputVec& outputVec,
+                            int multiThreadLevel,
+                            const JobOptions& options);
+
+/**
+ * @brief Creates a pool of workerCount long-lived threads that run jobs.
+ *
+ * Workers keep their intermediate buffers between jobs, so repeated small
+ * jobs skip thread creation and most vector growth.
+ */
+RuntimeHandle createRuntime(int workerCount);
+
+/**
+ * @brief Queues a MapReduce job on a runtime's shared workers.
+ *
+ * The job runs on min(multiThreadLevel, workerCount) workers once that many
+ * are idle; jobs start in submission order and run concurrently when they
+ * fit. The handle is used with waitForJob, getJobState and closeJobHandle as
+ * usual, but not from inside a job running on the same runtime.
+ */
+JobHandle startMapReduceJob(RuntimeHandle runtime,
+                            const MapReduceClient& client,
+                            const InputVec& inputVec,
+                            OutputVec& outputVec,
+                            int multiThreadLevel,
+                            const JobOptions& options = JobOptions());
+
+/**
+ * @brief Queues a MapReduce job over an InputSource on a runtime.
+ */
+JobHandle startMapReduceJob(RuntimeHandle runtime,
+                            const MapReduceClient& client,
+                            const InputSource& input,
+                            OutputVec& outputVec,
+                            int multiThreadLevel,
+                            const JobOptions& options = JobOptions());
+
+/**
+ * @brief Finishes every queued job, then stops and releases the workers.
+ *
+ * Handles of the runtime's jobs still need closeJobHandle.
+ */
+void closeRuntime(RuntimeHandle runtime);
+
 /**
  * @brief Waits for the MapReduce job to finish.
  */
 void waitForJob(JobHandle job);
 
+/**
+ * @brief Returns true once the job's output is complete, without blocking.
+ */
+bool isJobDone(JobHandle job);
+
+/**
+ * @brief Asks the job to stop early; returns without waiting.
+ *
+ * Threads stop mapping before their next chunk and skip the sorting ahead, and
+ * every pair not yet reduced goes to MapReduceClient::discard instead of
+ * reduce. The job still runs through its stages, so waitForJob returns
+ * promptly and the output holds whatever was reduced before the cancel.
+ * Safe to call from any thread, more than once, or on a finished job.
+ */
+void cancelJob(JobHandle job);
+
+/**
+ * @brief Returns true once the job was cancelled, by cancelJob or its deadline.
+ */
+bool isJobCancelled(JobHandle job);
+
 /**
  * @brief Gets the current state of the MapReduce job.
  */
 void getJobState(JobHandle job, JobState* state);
 
+/**
+ * @brief Copies the job's per-thread statistics once waitForJob has returned.
+ *
+ * stats->skew is filled by sorted, non-pipelined jobs. Returns false, leaving
+ * stats untouched, unless the job was started with JobOptions::collectStats.
+ */
+bool getJobStats(JobHandle job, JobStats* stats);
+
 /**
  * @brief Releases all resources of the MapReduce job.
  */
@@ -0,0 +1,244 @@
+#ifndef MAPREDUCEJOB_H
+#define MAPREDUCEJOB_H
+
+#include "FrameworkCommon.h"
+#include "Barrier.h"
+#include <vector>
+#include <utility>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <queue>
+#include <iterator>
+#include <system_error>
+
+/**
+ * @brief Typed MapReduce job over plain value types, a wrapper over the library.
+ *
+ * Keys and values are held by value in contiguous vectors and compared
+ * inline with their own operator<, so they need no K1..V3 base classes and
+ * no heap allocation. Threads, the barrier and the stage state work as in
+ * startMapReduceJob; the template includes the framework header (through
+ * FrameworkCommon.h) and needs libMapReduceFramework.a, which provides the
+ * Barrier. The Client type must provide:
+ *
+ *   void map(const K1& key, const V1& value, MapContext& context) const;
+ *   void reduce(const K2& key, const V2* values, size_t count,
+ *               ReduceContext& context) const;
+ *
+ * and emits through context.emit(key, value).
+ */
+template <typename K1, typename V1, typename K2, typename V2,
+          typename K3, typename V3, typename Client>
+class MapReduceJob {
+public:
+    typedef std::vector<std::pair<K1, V1>> InputVec;
+    typedef std::vector<std::pair<K2, V2>> IntermediateVec;
+    typedef std::vector<std::pair<K3, V3>> OutputVec;
+
+    /**
+     * @brief Collects the (K2, V2) pairs emitted by one thread's map calls.
+     */
+    class MapContext {
+    public:
+        template <typename K, typename V>
+        void emit(K&& key, V&& value) {
+            pairs.emplace_back(std::forward<K>(key), std::forward<V>(value));
+        }
+
+    private:
+        friend class MapReduceJob;
+        IntermediateVec pairs;
+    };
+
+    /**
+     * @brief Collects the (K3, V3) pairs emitted by one thread's reduce calls.
+     */
+    class ReduceContext {
+    public:
+        template <typename K, typename V>
+        void emit(K&& key, V&& value) {
+            pairs.emplace_back(std::forward<K>(key), std::forward<V>(value));
+        }
+
+    private:
+        friend class MapReduceJob;
+        OutputVec pairs;
+    };
+
+    /**
+     * @brief Starts the job; the client, input and output must outlive it.
+     */
+    MapReduceJob(const Client& client, const InputVec& inputVec,
+                 OutputVec& outputVec, int multiThreadLevel)
+        : client(client),
+          inputVec(inputVec),
+          outputVec(outputVec),
+          threadCount(multiThreadLevel),
+          mapContexts(multiThreadLevel),
+          vecIndex(0),
+          processed(0),
+          barrier(multiThreadLevel),
+          joined(false)
+    {
+        setStage(MAP_STAGE, inputVec.size());
+        for (int i = 0; i < threadCount; ++i) {
+            try {
+                threads.emplace_back(&MapReduceJob::run, this, i);
+            } catch (const std::system_error& e) {
+                SYSTEM_ERROR_MSG("failed to create thread: " << e.what());
+                EXIT_ON_ERROR(ERROR_EXIT_CODE);
+            }
+        }
+    }
+
+    MapReduceJob(const MapReduceJob&) = delete;
+    MapReduceJob& operator=(const MapReduceJob&) = delete;
+
+    ~MapReduceJob() { wait(); }
+
+    /**
+     * @brief Waits for the job to finish (safe to call multiple times).
+     */
+    void wait() {
+        if (joined) return;
+        try {
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        } catch (const std::system_error& e) {
+            SYSTEM_ERROR_MSG("failed to join thread: " << e.what());
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+        joined = true;
+    }
+
+    /**
+     * @brief Gets the current stage and progress of the job.
+     */
+    void getJobState(JobState* state) const {
+        uint64_t snapshot;
+        uint64_t total;
+        uint64_t count;
+        do {
+            snapshot = stageState.begin();
+            total = stageState.total();
+            count = processed.load();
+        } while (!stageState.validate(snapshot));
+        fillJobState(snapshot, count, total, state);
+    }
+
+private:
+    /**
+     * @brief Publishes a new stage and resets the processed count with it.
+     */
+    void setStage(stage_t stage, uint64_t total) {
+        stageState.beginChange();
+        processed.store(0);
+        stageState.endChange(stage, total);
+    }
+
+    static bool keyLess(const std::pair<K2, V2>& a, const std::pair<K2, V2>& b) {
+        return a.first < b.first;
+    }
+
+    /**
+     * @brief Main function executed by each worker thread.
+     */
+    void run(int threadId) {
+        MapContext& mapContext = mapContexts[threadId];
+        size_t index;
+
+        // Map phase
+        while ((index = vecIndex.fetch_add(1)) < inputVec.size()) {
+            client.map(inputVec[index].first, inputVec[index].second, mapContext);
+            processed.fetch_add(1);
+        }
+        std::sort(mapContext.pairs.begin(), mapContext.pairs.end(), keyLess);
+        barrier.barrier();
+
+        // Shuffle phase (only thread 0)
+        if (threadId == 0) {
+            shuffle();
+            setStage(REDUCE_STAGE, groupKeys.size());
+            vecIndex.store(0);
+        }
+        barrier.barrier();
+
+        // Reduce phase
+        ReduceContext reduceContext;
+        while ((index = vecIndex.fetch_add(1)) < groupKeys.size()) {
+            client.reduce(groupKeys[index], values.data() + groupOffsets[index],
+                          groupOffsets[index + 1] - groupOffsets[index], reduceContext);
+            processed.fetch_add(1);
+        }
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::move(reduceContext.pairs.begin(), reduceContext.pairs.end(),
+                  std::back_inserter(outputVec));
+    }
+
+    /**
+     * @brief Merges the sorted runs into one key per group and flat values.
+     */
+    void shuffle() {
+        size_t totalPairs = 0;
+        for (const MapContext& context : mapContexts) {
+            totalPairs += context.pairs.size();
+        }
+        setStage(SHUFFLE_STAGE, totalPairs);
+        values.reserve(totalPairs);
+
+        // Min-heap of run indices ordered by each run's current head key
+        std::vector<size_t> heads(threadCount, 0);
+        auto headGreater = [this, &heads](int a, int b) {
+            return mapContexts[b].pairs[heads[b]].first < mapContexts[a].pairs[heads[a]].first;
+        };
+        std::priority_queue<int, std::vector<int>, decltype(headGreater)> pq(headGreater);
+        for (int i = 0; i < threadCount; ++i) {
+            if (!mapContexts[i].pairs.empty()) pq.push(i);
+        }
+
+        while (!pq.empty()) {
+            int run = pq.top();
+            pq.pop();
+            std::pair<K2, V2>& pair = mapContexts[run].pairs[heads[run]];
+            if (groupKeys.empty() || groupKeys.back() < pair.first) {
+                if (!groupKeys.empty()) {
+                    processed.fetch_add(values.size() - groupOffsets.back());
+                }
+                groupOffsets.push_back(values.size());
+                groupKeys.push_back(std::move(pair.first));
+            }
+            values.push_back(std::move(pair.second));
+            if (++heads[run] < mapContexts[run].pairs.size()) pq.push(run);
+        }
+        if (!groupKeys.empty()) {
+            processed.fetch_add(values.size() - groupOffsets.back());
+        }
+        groupOffsets.push_back(values.size());
+
+        for (MapContext& context : mapContexts) {
+            IntermediateVec().swap(context.pairs);
+        }
+    }
+
+    const Client& client;
+    const InputVec& inputVec;
+    OutputVec& outputVec;
+    int threadCount;
+    std::vector<std::thread> threads;
+    std::vector<MapContext> mapContexts;   // Per-thread sorted runs
+    std::vector<K2> groupKeys;             // One key per shuffled group
+    std::vector<V2> values;                // Values of all groups, back to back
+    std::vector<size_t> groupOffsets;      // Group i spans [offsets[i], offsets[i + 1])
+    std::atomic<size_t> vecIndex;
+    StageState stageState;
+    std::atomic<uint64_t> processed;       // Items done in the current stage
+    Barrier barrier;
+    std::mutex outputMutex;
+    bool joined;
+};
+
+#endif // MAPREDUCEJOB_H
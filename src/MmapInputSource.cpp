@@ -0,0 +1,66 @@
+#include "MmapInputSource.h"
+#include "FrameworkCommon.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ======================[ MmapLineSource Implementation ]===========
+
+MmapLineSource::MmapLineSource(const std::string& path, size_t chunkBytes)
+    : data(nullptr),
+      size(0),
+      chunkBytes(std::max<size_t>(1, chunkBytes))
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        SYSTEM_ERROR_MSG("failed to open input file " << path << ": " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    size = static_cast<size_t>(info.st_size);
+    if (size > 0) {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            SYSTEM_ERROR_MSG("failed to map input file " << path << ": " << strerror(errno));
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    close(fd);
+}
+
+MmapLineSource::~MmapLineSource() {
+    if (data != nullptr) {
+        munmap(const_cast<char*>(data), size);
+    }
+}
+
+size_t MmapLineSource::chunkCount() const {
+    return (size + chunkBytes - 1) / chunkBytes;
+}
+
+void MmapLineSource::mapChunk(size_t chunk, const MapReduceClient& client, void* context) const {
+    const char* fileEnd = data + size;
+    const char* pos = data + chunk * chunkBytes;
+    const char* chunkEnd = data + std::min(size, (chunk + 1) * chunkBytes);
+
+    // A line that started in the previous chunk belongs to that chunk
+    if (chunk > 0 && pos[-1] != '\n') {
+        const char* newline = static_cast<const char*>(memchr(pos, '\n', fileEnd - pos));
+        pos = (newline == nullptr) ? fileEnd : newline + 1;
+    }
+
+    while (pos < chunkEnd) {
+        const char* newline = static_cast<const char*>(memchr(pos, '\n', fileEnd - pos));
+        const char* lineEnd = (newline == nullptr) ? fileEnd : newline;
+        LineKey key(static_cast<uint64_t>(pos - data));
+        LineValue value(pos, static_cast<size_t>(lineEnd - pos));
+        client.map(&key, &value, context);
+        pos = lineEnd + 1;
+    }
+}
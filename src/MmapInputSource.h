@@ -0,0 +1,63 @@
+#ifndef MMAPINPUTSOURCE_H
+#define MMAPINPUTSOURCE_H
+
+#include "InputSource.h"
+#include <cstdint>
+#include <string>
+
+// ======================[ Line Record Types ]=======================
+
+/**
+ * @brief Input key of a line record: its byte offset in the file.
+ */
+class LineKey : public K1 {
+public:
+    explicit LineKey(uint64_t offset) : offset(offset) {}
+    bool operator<(const K1& other) const override {
+        return offset < static_cast<const LineKey&>(other).offset;
+    }
+    uint64_t offset;
+};
+
+/**
+ * @brief Input value of a line record: a view into the mapped file.
+ *
+ * The view excludes the trailing newline and its bytes stay valid while the
+ * source lives; the LineKey and LineValue objects themselves only live for
+ * the duration of the map call.
+ */
+class LineValue : public V1 {
+public:
+    LineValue(const char* data, size_t size) : data(data), size(size) {}
+    const char* data;
+    size_t size;
+};
+
+// ======================[ MmapLineSource ]==========================
+
+/**
+ * @brief Memory-maps a text file and maps it line by line, without copying.
+ *
+ * The file is cut into chunks of chunkBytes; a chunk owns every line that
+ * starts inside it, so lines crossing a chunk boundary are mapped exactly once.
+ */
+class MmapLineSource : public InputSource {
+public:
+    explicit MmapLineSource(const std::string& path, size_t chunkBytes = DEFAULT_CHUNK_BYTES);
+    ~MmapLineSource();
+
+    MmapLineSource(const MmapLineSource&) = delete;
+    MmapLineSource& operator=(const MmapLineSource&) = delete;
+
+    size_t chunkCount() const override;
+    void mapChunk(size_t chunk, const MapReduceClient& client, void* context) const override;
+
+    static const size_t DEFAULT_CHUNK_BYTES = 1 << 20;
+
+private:
+    const char* data;
+    size_t size;
+    size_t chunkBytes;
+};
+
+#endif // MMAPINPUTSOURCE_H
@@ -0,0 +1,171 @@
+#include "OutputSink.h"
+#include "FrameworkCommon.h"
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+// ======================[ Constants & Macros ]======================
+
+#define OUTPUT_FLUSH_BYTES (1 << 16)
+
+// ======================[ VectorOutputSink ]========================
+
+void VectorOutputSink::open(int threadCount) {
+    buffers.assign(threadCount, OutputVec());
+}
+
+void VectorOutputSink::write(int thread, K3* key, V3* value) {
+    buffers[thread].emplace_back(key, value);
+}
+
+void VectorOutputSink::finish(int thread) {
+    OutputVec& buffer = buffers[thread];
+    std::lock_guard<std::mutex> lock(mutex);
+    outputVec.insert(outputVec.end(), buffer.begin(), buffer.end());
+    OutputVec().swap(buffer);
+}
+
+// ======================[ FileOutputSink ]==========================
+
+FileOutputSink::FileOutputSink(const std::string& path, const OutputFormatter& formatter)
+    : formatter(formatter),
+      file(std::fopen(path.c_str(), "wb"))
+{
+    if (file == nullptr) {
+        SYSTEM_ERROR_MSG("failed to open output file " << path << ": " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+}
+
+FileOutputSink::~FileOutputSink() {
+    if (std::fclose(file) != 0) {
+        SYSTEM_ERROR_MSG("failed to close output file: " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+}
+
+void FileOutputSink::open(int threadCount) {
+    buffers.assign(threadCount, std::string());
+}
+
+void FileOutputSink::write(int thread, K3* key, V3* value) {
+    std::string& buffer = buffers[thread];
+    formatter.format(key, value, buffer);
+    formatter.release(key, value);
+    if (buffer.size() >= OUTPUT_FLUSH_BYTES) {
+        flush(buffer);
+    }
+}
+
+void FileOutputSink::finish(int thread) {
+    flush(buffers[thread]);
+    std::string().swap(buffers[thread]);
+}
+
+void FileOutputSink::flush(std::string& buffer) {
+    if (buffer.empty()) return;
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        SYSTEM_ERROR_MSG("failed to write output file: " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    buffer.clear();
+}
+
+// ======================[ QueueOutputSink ]=========================
+
+QueueOutputSink::QueueOutputSink(size_t capacity)
+    : capacity(capacity > 0 ? capacity : 1),
+      ringCount(0),
+      opened(false),
+      nextRing(0),
+      finished(0),
+      sleepers(0)
+{ }
+
+void QueueOutputSink::open(int threadCount) {
+    std::unique_ptr<Ring[]> created(new Ring[threadCount]);
+    for (int i = 0; i < threadCount; ++i) {
+        created[i].slots.reset(new OutputPair[capacity]);
+        created[i].head.store(0);
+        created[i].tail.store(0);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    rings = std::move(created);
+    ringCount = threadCount;
+    opened = true;
+    cv.notify_all();
+}
+
+void QueueOutputSink::wake() {
+    // Waiters raise sleepers before re-checking their condition under the
+    // mutex, and ring updates are sequentially consistent, so either the
+    // waiter sees the update or this load sees the waiter
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cv.notify_all();
+    }
+}
+
+void QueueOutputSink::write(int thread, K3* key, V3* value) {
+    Ring& ring = rings[thread];
+    size_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.head.load() == capacity) {
+        std::unique_lock<std::mutex> lock(mutex);
+        sleepers.fetch_add(1);
+        cv.wait(lock, [this, &ring, tail] { return tail - ring.head.load() < capacity; });
+        sleepers.fetch_sub(1);
+    }
+    ring.slots[tail % capacity] = OutputPair(key, value);
+    ring.tail.store(tail + 1);
+    wake();
+}
+
+void QueueOutputSink::finish(int /*thread*/) {
+    finished.fetch_add(1);
+    std::lock_guard<std::mutex> lock(mutex);
+    cv.notify_all();
+}
+
+bool QueueOutputSink::tryPop(OutputPair* pair) {
+    for (int k = 0; k < ringCount; ++k) {
+        size_t index = (nextRing + k) % ringCount;
+        Ring& ring = rings[index];
+        size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head != ring.tail.load()) {
+            *pair = ring.slots[head % capacity];
+            ring.head.store(head + 1);
+            nextRing = index + 1;
+            wake();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool QueueOutputSink::pop(OutputPair* pair) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return opened; });
+    }
+    while (true) {
+        // Read finished first: rings are only drained for good once it is full
+        bool allFinished = finished.load() == ringCount;
+        if (tryPop(pair)) {
+            return true;
+        }
+        if (allFinished) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        sleepers.fetch_add(1);
+        cv.wait(lock, [this] {
+            if (finished.load() == ringCount) return true;
+            for (int k = 0; k < ringCount; ++k) {
+                if (rings[k].head.load() != rings[k].tail.load()) return true;
+            }
+            return false;
+        });
+        sleepers.fetch_sub(1);
+    }
+}
@@ -0,0 +1,155 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include "MapReduceClient.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ======================[ OutputSink Interface ]====================
+
+/**
+ * @brief Destination of a job's (K3, V3) pairs, fed while reduce runs.
+ *
+ * Set through JobOptions::outputSink; emit3 then hands every pair to write
+ * instead of buffering it for the job's OutputVec. Job thread t calls
+ * write(t, ...) sequentially, and different threads call it concurrently.
+ * A sink serves one job and must outlive it.
+ */
+class OutputSink {
+public:
+    virtual ~OutputSink() {}
+
+    /**
+     * @brief Called once, before any thread starts, with the job's thread count.
+     */
+    virtual void open(int /*threadCount*/) { }
+
+    /**
+     * @brief Takes ownership of one output pair emitted by the given thread.
+     */
+    virtual void write(int thread, K3* key, V3* value) = 0;
+
+    /**
+     * @brief Called once per thread after its last write.
+     */
+    virtual void finish(int /*thread*/) { }
+};
+
+// ======================[ VectorOutputSink ]========================
+
+/**
+ * @brief Collects pairs in per-thread buffers, appended to an OutputVec
+ * (under a lock) as each thread finishes.
+ */
+class VectorOutputSink : public OutputSink {
+public:
+    explicit VectorOutputSink(OutputVec& outputVec) : outputVec(outputVec) {}
+
+    void open(int threadCount) override;
+    void write(int thread, K3* key, V3* value) override;
+    void finish(int thread) override;
+
+private:
+    OutputVec& outputVec;
+    std::vector<OutputVec> buffers;
+    std::mutex mutex;
+};
+
+// ======================[ FileOutputSink ]==========================
+
+/**
+ * @brief Turns output pairs into bytes for FileOutputSink.
+ */
+class OutputFormatter {
+public:
+    virtual ~OutputFormatter() {}
+
+    /**
+     * @brief Appends the text or byte form of (key, value) to out.
+     */
+    virtual void format(const K3* key, const V3* value, std::string& out) const = 0;
+
+    /**
+     * @brief Frees a pair once it has been formatted.
+     */
+    virtual void release(K3* key, V3* value) const {
+        delete key;
+        delete value;
+    }
+};
+
+/**
+ * @brief Formats pairs into per-thread buffers that are written to a file
+ * in large blocks; pairs are released as soon as they are formatted.
+ */
+class FileOutputSink : public OutputSink {
+public:
+    FileOutputSink(const std::string& path, const OutputFormatter& formatter);
+    ~FileOutputSink();
+
+    FileOutputSink(const FileOutputSink&) = delete;
+    FileOutputSink& operator=(const FileOutputSink&) = delete;
+
+    void open(int threadCount) override;
+    void write(int thread, K3* key, V3* value) override;
+    void finish(int thread) override;
+
+private:
+    void flush(std::string& buffer);
+
+    const OutputFormatter& formatter;
+    FILE* file;
+    std::vector<std::string> buffers;
+    std::mutex fileMutex;
+};
+
+// ======================[ QueueOutputSink ]=========================
+
+/**
+ * @brief Hands pairs to one consumer thread through bounded queues.
+ *
+ * Each job thread owns a single-producer single-consumer ring of the given
+ * capacity. A producer whose ring is full blocks until the consumer catches
+ * up, so reduce runs at most capacity pairs per thread ahead of it.
+ */
+class QueueOutputSink : public OutputSink {
+public:
+    explicit QueueOutputSink(size_t capacity);
+
+    void open(int threadCount) override;
+    void write(int thread, K3* key, V3* value) override;
+    void finish(int thread) override;
+
+    /**
+     * @brief Blocks for the next pair; returns false once every thread has
+     * finished and all rings are drained. Call from one thread only.
+     */
+    bool pop(OutputPair* pair);
+
+private:
+    struct Ring {
+        std::unique_ptr<OutputPair[]> slots;
+        std::atomic<size_t> head;          // Next slot to consume
+        std::atomic<size_t> tail;          // Next slot to fill
+    };
+
+    bool tryPop(OutputPair* pair);
+    void wake();
+
+    const size_t capacity;
+    std::unique_ptr<Ring[]> rings;
+    int ringCount;                         // Set by open (guarded by mutex until then)
+    bool opened;
+    size_t nextRing;                       // Round-robin start for the consumer
+    std::atomic<int> finished;             // Threads that called finish
+    std::atomic<int> sleepers;             // Producers and consumer blocked on cv
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+#endif // OUTPUTSINK_H
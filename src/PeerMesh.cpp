@@ -0,0 +1,177 @@
+#include "PeerMesh.h"
+#include "FrameworkCommon.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ======================[ Constants & Macros ]======================
+
+#define CONNECT_RETRY_MS 50
+
+// ======================[ Helper Functions ]========================
+
+/**
+ * @brief Splits "host:port" at the last colon.
+ */
+static void splitAddress(const std::string& address, std::string* host, std::string* port) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        SYSTEM_ERROR_MSG("bad node address " << address << " (expected host:port)");
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    *host = address.substr(0, colon);
+    *port = address.substr(colon + 1);
+}
+
+static addrinfo* resolve(const std::string& address, bool passive) {
+    std::string host, port;
+    splitAddress(address, &host, &port);
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    addrinfo* result = nullptr;
+    int status = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (status != 0) {
+        SYSTEM_ERROR_MSG("failed to resolve " << address << ": " << gai_strerror(status));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    return result;
+}
+
+static int listenOn(const std::string& address) {
+    addrinfo* info = resolve(address, true);
+    int fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    int enable = 1;
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0 ||
+        bind(fd, info->ai_addr, info->ai_addrlen) != 0 || listen(fd, SOMAXCONN) != 0) {
+        SYSTEM_ERROR_MSG("failed to listen on " << address << ": " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    freeaddrinfo(info);
+    return fd;
+}
+
+/**
+ * @brief Dials address, retrying until the peer listens or timeoutMs passes.
+ */
+static int dial(const std::string& address, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        addrinfo* info = resolve(address, false);
+        int fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) {
+            SYSTEM_ERROR_MSG("failed to create socket: " << strerror(errno));
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+        bool connected = connect(fd, info->ai_addr, info->ai_addrlen) == 0;
+        freeaddrinfo(info);
+        if (connected) {
+            return fd;
+        }
+        close(fd);
+        if (std::chrono::steady_clock::now() >= deadline) {
+            SYSTEM_ERROR_MSG("failed to connect to " << address << ": " << strerror(errno));
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_RETRY_MS));
+    }
+}
+
+// ======================[ PeerMesh Implementation ]=================
+
+PeerMesh::PeerMesh(const ClusterSpec& spec)
+    : spec(spec),
+      selfRank(spec.rank),
+      listener(-1),
+      sockets(spec.nodes.size(), -1)
+{
+    int count = static_cast<int>(spec.nodes.size());
+    if (selfRank < 0 || selfRank >= count) {
+        SYSTEM_ERROR_MSG("cluster rank " << selfRank << " is outside " << count << " nodes");
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    if (selfRank + 1 < count) {
+        listener = listenOn(spec.nodes[selfRank]);
+    }
+}
+
+void PeerMesh::connect() {
+    int count = size();
+    for (int peer = 0; peer < selfRank; ++peer) {
+        sockets[peer] = dial(spec.nodes[peer], spec.connectTimeoutMs);
+        uint32_t rank = htonl(static_cast<uint32_t>(selfRank));
+        send(peer, reinterpret_cast<const char*>(&rank), sizeof(rank));
+    }
+    for (int accepted = selfRank + 1; accepted < count; ++accepted) {
+        int fd = accept(listener, nullptr, nullptr);
+        uint32_t rank = 0;
+        if (fd < 0 || recv(fd, &rank, sizeof(rank), MSG_WAITALL) != sizeof(rank)) {
+            SYSTEM_ERROR_MSG("failed to accept a cluster peer: " << strerror(errno));
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+        int peer = static_cast<int>(ntohl(rank));
+        if (peer <= selfRank || peer >= count || sockets[peer] != -1) {
+            SYSTEM_ERROR_MSG("unexpected cluster peer rank " << peer);
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+        sockets[peer] = fd;
+    }
+    if (listener >= 0) {
+        close(listener);
+        listener = -1;
+    }
+
+    int enable = 1;
+    for (int fd : sockets) {
+        if (fd >= 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+    }
+}
+
+PeerMesh::~PeerMesh() {
+    if (listener >= 0) {
+        close(listener);
+    }
+    for (int fd : sockets) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+void PeerMesh::send(int peer, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(sockets[peer], data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) {
+            SYSTEM_ERROR_MSG("failed to send to cluster node " << peer << ": " << strerror(errno));
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+}
+
+void PeerMesh::receive(int peer, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(sockets[peer], data, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) {
+            SYSTEM_ERROR_MSG("failed to receive from cluster node " << peer << ": "
+                             << (received == 0 ? "connection closed" : strerror(errno)));
+            EXIT_ON_ERROR(ERROR_EXIT_CODE);
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef PEERMESH_H
+#define PEERMESH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Where one process sits in a distributed job.
+ *
+ * Every node runs the same job with the same nodes list and its own rank.
+ * Rank 0 also coordinates: it picks the key ranges each node reduces.
+ */
+struct ClusterSpec {
+    int rank;                              // This node's index into nodes
+    std::vector<std::string> nodes;        // "host:port" of every node, by rank
+    bool splitInput;                       // Map only this rank's share of the input chunks
+    int connectTimeoutMs;                  // How long to wait for the other nodes to listen
+
+    ClusterSpec()
+        : rank(0),
+          splitInput(true),
+          connectTimeoutMs(60000)
+    { }
+};
+
+/**
+ * @brief Fully connected TCP sockets between the nodes of a ClusterSpec.
+ *
+ * The constructor only starts listening on this node's address, so peers
+ * can dial it as soon as the job starts; connect then dials the lower ranks
+ * and accepts the higher ones, and every connection starts with the dialer's
+ * rank. Socket failures are system errors. A connection may be read by one
+ * thread while another writes to it.
+ */
+class PeerMesh {
+public:
+    explicit PeerMesh(const ClusterSpec& spec);
+    ~PeerMesh();
+
+    PeerMesh(const PeerMesh&) = delete;
+    PeerMesh& operator=(const PeerMesh&) = delete;
+
+    /**
+     * @brief Connects to every other node; blocks until all of them are reachable.
+     */
+    void connect();
+
+    int rank() const { return selfRank; }
+    int size() const { return static_cast<int>(sockets.size()); }
+
+    /**
+     * @brief Writes all size bytes to the given peer.
+     */
+    void send(int peer, const char* data, size_t size);
+
+    /**
+     * @brief Reads exactly size bytes from the given peer.
+     */
+    void receive(int peer, char* data, size_t size);
+
+private:
+    const ClusterSpec spec;
+    int selfRank;
+    int listener;                          // Listening socket until connect, or -1
+    std::vector<int> sockets;              // One per rank; -1 for this node
+};
+
+#endif // PEERMESH_H
@@ -0,0 +1,66 @@
+#include "SpillFile.h"
+#include "FrameworkCommon.h"
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+// ======================[ Constants & Macros ]======================
+
+#define SPILL_IO_BUFFER_SIZE (1 << 20)
+
+// ======================[ SpillFile Implementation ]================
+
+SpillFile::SpillFile(const std::string& directory)
+    : file(nullptr),
+      recordCount(0),
+      byteCount(0)
+{
+    std::string pattern = directory + "/mapreduce-spill-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+
+    int fd = mkstemp(path.data());
+    if (fd < 0 || unlink(path.data()) != 0 || (file = fdopen(fd, "w+b")) == nullptr) {
+        SYSTEM_ERROR_MSG("failed to create spill file in " << directory << ": " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    setvbuf(file, nullptr, _IOFBF, SPILL_IO_BUFFER_SIZE);
+}
+
+SpillFile::~SpillFile() {
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+void SpillFile::append(const std::string& record) {
+    uint32_t size = static_cast<uint32_t>(record.size());
+    if (fwrite(&size, sizeof(size), 1, file) != 1 ||
+        (size > 0 && fwrite(record.data(), size, 1, file) != 1)) {
+        SYSTEM_ERROR_MSG("failed to write spill file: " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    ++recordCount;
+    byteCount += sizeof(size) + size;
+}
+
+void SpillFile::rewind() {
+    if (fflush(file) != 0 || fseek(file, 0, SEEK_SET) != 0) {
+        SYSTEM_ERROR_MSG("failed to rewind spill file: " << strerror(errno));
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+}
+
+bool SpillFile::next(std::string& record) {
+    uint32_t size;
+    if (fread(&size, sizeof(size), 1, file) != 1) {
+        return false;
+    }
+    record.resize(size);
+    if (size > 0 && fread(&record[0], size, 1, file) != 1) {
+        SYSTEM_ERROR_MSG("failed to read spill file: truncated record");
+        EXIT_ON_ERROR(ERROR_EXIT_CODE);
+    }
+    return true;
+}
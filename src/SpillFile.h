@@ -0,0 +1,47 @@
+#ifndef SPILLFILE_H
+#define SPILLFILE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Anonymous temporary file of length-prefixed records.
+ *
+ * Records are appended sequentially, then the file is rewound and read back
+ * in the same order. The file is unlinked as soon as it is created, so it
+ * disappears when the object is destroyed or the process exits.
+ */
+class SpillFile {
+public:
+    explicit SpillFile(const std::string& directory);
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    /**
+     * @brief Appends one record.
+     */
+    void append(const std::string& record);
+
+    /**
+     * @brief Flushes pending writes and moves back to the first record.
+     */
+    void rewind();
+
+    /**
+     * @brief Reads the next record; returns false at the end of the file.
+     */
+    bool next(std::string& record);
+
+    uint64_t records() const { return recordCount; }
+    uint64_t bytes() const { return byteCount; }
+
+private:
+    FILE* file;
+    uint64_t recordCount;
+    uint64_t byteCount;
+};
+
+#endif // SPILLFILE_H
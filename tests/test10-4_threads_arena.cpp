@@ -0,0 +1,67 @@
+/**
+ * @brief run 4 threads allocating intermediate pairs from the job arena
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include "Arena.h"
+#include <algorithm>
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(newIntermediate<elements>(context, input),
+              newIntermediate<elements>(context, 1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+    }
+};
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads);
+    closeJobHandle(job);
+
+    std::sort(outputVec.begin(), outputVec.end(),
+              [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+    for (OutputPair &p : outputVec) {
+        std::cout << "thread 1 out:\t" << static_cast<elements*>(p.second)->num << '\n';
+    }
+    for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+
+    // A block-sized request gets its own block; the current one keeps filling
+    Arena arena(1024);
+    char* first = static_cast<char*>(arena.allocate(16));
+    arena.allocate(1024);
+    char* next = static_cast<char*>(arena.allocate(16));
+    std::cout << "arena keeps the current block: " << (next == first + 16) << '\n';
+    return 0;
+}
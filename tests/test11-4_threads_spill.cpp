@@ -0,0 +1,89 @@
+/**
+ * @brief run 4 threads under a small memory budget - sorted runs spill to disk and merge back
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <cstring>
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class serializer : public IntermediateSerializer {
+public:
+    void serialize(const K2* key, const V2* value, std::string& out) const override {
+        int nums[2] = { static_cast<const elements*>(key)->num,
+                        static_cast<const elements*>(value)->num };
+        out.append(reinterpret_cast<const char*>(nums), sizeof(nums));
+    }
+    IntermediatePair deserialize(const char* data, size_t size) const override {
+        int nums[2];
+        if (size != sizeof(nums)) return IntermediatePair(nullptr, nullptr);
+        std::memcpy(nums, data, sizeof(nums));
+        return IntermediatePair(new elements(nums[0]), new elements(nums[1]));
+    }
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    serializer spillFormat;
+    bool pipelined[] = { false, true, true };
+    shuffle_mode_t modes[] = { SHUFFLE_SERIAL, SHUFFLE_SERIAL, SHUFFLE_PARALLEL };
+    for (unsigned m = 0; m < 3; ++m) {
+        JobOptions options;
+        options.memoryBudget = 20000;
+        options.serializer = &spillFormat;
+        options.pipelineReduce = pipelined[m];
+        options.shuffleMode = modes[m]; // Spilling falls back to the serial merge
+        JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+        closeJobHandle(job);
+
+        std::sort(outputVec.begin(), outputVec.end(),
+                  [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+        for (OutputPair &p : outputVec) {
+            std::cout << "thread " << m+1 << " out:\t" << static_cast<elements*>(p.second)->num << '\n';
+        }
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+        outputVec.clear();
+    }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
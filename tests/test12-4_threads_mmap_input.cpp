@@ -0,0 +1,70 @@
+/**
+ * @brief run 4 threads over a memory-mapped file - counts match test1 for the same numbers
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include "MmapInputSource.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+unsigned int unique_keys = 100;
+
+class elements : public K2, public K3, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* /*key*/, const V1* val, void* context) const override {
+        const LineValue* line = static_cast<const LineValue*>(val);
+        int input = std::atoi(std::string(line->data, line->size).c_str()) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+int main() {
+    const char* path = "/tmp/test12-mmap_input.txt";
+    std::srand(0);
+    FILE* file = std::fopen(path, "w");
+    for (int j = 0; j < 100000; ++j) {
+        std::fprintf(file, j + 1 < 100000 ? "%d\n" : "%d", std::rand());
+    }
+    std::fclose(file);
+
+    OutputVec outputVec;
+    tester client;
+    {
+        // Small chunks so many lines straddle chunk boundaries
+        MmapLineSource input(path, 4099);
+        JobHandle job = startMapReduceJob(client, input, outputVec, 4);
+        closeJobHandle(job);
+    }
+    std::remove(path);
+
+    std::sort(outputVec.begin(), outputVec.end(),
+              [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+    for (OutputPair &p : outputVec) {
+        std::cout << "thread 1 out:\t" << static_cast<elements*>(p.second)->num << '\n';
+    }
+    for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+    return 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * @brief run 4 threads with per-thread outputs merged in key order - no sort needed afterwards
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    JobOptions options;
+    options.sortedOutput = true;
+    JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+    closeJobHandle(job);
+
+    for (OutputPair &p : outputVec) {
+        std::cout << "thread 1 out:\t" << static_cast<elements*>(p.second)->num << '\n';
+    }
+    for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
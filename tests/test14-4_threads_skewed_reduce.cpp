@@ -0,0 +1,80 @@
+/**
+ * @brief run 4 threads reducing largest groups first, then with oversized groups split into combined slices
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void combine(const IntermediateVec* pairs, void* context) const override {
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        int count = sum(pairs);
+        emit2(new elements(key), new elements(count), context);
+    }
+    bool hasCombiner() const override { return true; }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        int count = sum(pairs);
+        emit3(new elements(key), new elements(count), context);
+    }
+private:
+    // Sums the counts of a group and releases its pairs
+    static int sum(const IntermediateVec* pairs) {
+        int total = 0;
+        for (const IntermediatePair& pair : *pairs) {
+            total += static_cast<const elements*>(pair.second)->num;
+            delete pair.first;
+            delete pair.second;
+        }
+        return total;
+    }
+};
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    size_t splitSizes[] = { 0, 2 };
+    for (unsigned m = 0; m < 2; ++m) {
+        JobOptions options;
+        options.reduceOrder = REDUCE_LARGEST_FIRST;
+        options.splitGroupPairs = splitSizes[m];
+        JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+        closeJobHandle(job);
+
+        std::sort(outputVec.begin(), outputVec.end(),
+                  [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+        for (OutputPair &p : outputVec) {
+            std::cout << "thread " << m+1 << " out:\t" << static_cast<elements*>(p.second)->num << '\n';
+        }
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+        outputVec.clear();
+    }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
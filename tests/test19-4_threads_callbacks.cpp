@@ -0,0 +1,111 @@
+/**
+ * @brief run two concurrent 4 thread jobs driven by stage and completion callbacks - same groups as test1
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+struct Events {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<int> stages[2];
+    int done = 0;
+};
+
+struct Tag {
+    Events* events;
+    int job;
+};
+
+void onStage(JobHandle, stage_t stage, void* data) {
+    Tag* tag = static_cast<Tag*>(data);
+    std::lock_guard<std::mutex> lock(tag->events->mutex);
+    tag->events->stages[tag->job].push_back(stage);
+}
+
+void onDone(JobHandle, void* data) {
+    Tag* tag = static_cast<Tag*>(data);
+    std::lock_guard<std::mutex> lock(tag->events->mutex);
+    tag->events->done++;
+    tag->events->cv.notify_all();
+}
+
+int main() {
+    InputVec inputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    Events events;
+    Tag tags[2] = { { &events, 0 }, { &events, 1 } };
+    OutputVec outputVecs[2];
+    JobHandle jobs[2];
+    for (int m = 0; m < 2; ++m) {
+        JobOptions options;
+        options.shuffleMode = m == 0 ? SHUFFLE_SERIAL : SHUFFLE_PARALLEL;
+        options.onStage = onStage;
+        options.onDone = onDone;
+        options.callbackData = &tags[m];
+        jobs[m] = startMapReduceJob(client, inputVec, outputVecs[m], 4, options);
+    }
+    {
+        std::unique_lock<std::mutex> lock(events.mutex);
+        events.cv.wait(lock, [&events] { return events.done == 2; });
+    }
+
+    for (int m = 0; m < 2; ++m) {
+        closeJobHandle(jobs[m]);
+        OutputVec& outputVec = outputVecs[m];
+        std::sort(outputVec.begin(), outputVec.end(),
+                  [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+        for (OutputPair &p : outputVec) {
+            std::cout << "thread " << m+1 << " out:\t" << static_cast<elements*>(p.second)->num << '\n';
+        }
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+    }
+    for (int m = 0; m < 2; ++m) {
+        std::cout << "thread " << m+1 << " stages:";
+        for (int stage : events.stages[m]) std::cout << ' ' << stage;
+        std::cout << '\n';
+    }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @brief run 4 threads into a bounded queue sink and a file sink - same groups as test1
+ */
+
+#include <iostream>
+#include <fstream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <map>
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+class lineFormatter : public OutputFormatter {
+public:
+    void format(const K3* key, const V3* value, std::string& out) const override {
+        out += std::to_string(static_cast<const elements*>(key)->num) + ' ' +
+               std::to_string(static_cast<const elements*>(value)->num) + '\n';
+    }
+};
+
+int main() {
+    InputVec inputVec;
+    tester client;
+    const char* path = "/tmp/test20-output_sink.txt";
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    // Queue sink: consume while the pipelined reduce is still running
+    {
+        OutputVec unused;
+        QueueOutputSink sink(16);
+        JobOptions options;
+        options.shuffleMode = SHUFFLE_PARALLEL;
+        options.pipelineReduce = true;
+        options.outputSink = &sink;
+        JobHandle job = startMapReduceJob(client, inputVec, unused, 4, options);
+
+        std::map<int, int> counts;
+        OutputPair pair;
+        while (sink.pop(&pair)) {
+            counts[static_cast<elements*>(pair.first)->num] = static_cast<elements*>(pair.second)->num;
+            delete pair.first;
+            delete pair.second;
+        }
+        closeJobHandle(job);
+        for (const auto& entry : counts) {
+            std::cout << "thread 1 out:\t" << entry.second << '\n';
+        }
+    }
+
+    // File sink: pairs are formatted and released by the reducers
+    {
+        OutputVec unused;
+        lineFormatter formatter;
+        {
+            FileOutputSink sink(path, formatter);
+            JobOptions options;
+            options.outputSink = &sink;
+            JobHandle job = startMapReduceJob(client, inputVec, unused, 4, options);
+            closeJobHandle(job);
+        }
+        std::map<int, int> counts;
+        std::ifstream file(path);
+        int key, count;
+        while (file >> key >> count) {
+            counts[key] = count;
+        }
+        for (const auto& entry : counts) {
+            std::cout << "thread 2 out:\t" << entry.second << '\n';
+        }
+        std::remove(path);
+    }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
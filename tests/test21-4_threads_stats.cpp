@@ -0,0 +1,91 @@
+/**
+ * @brief run 4 threads with stats collection and a Chrome trace dump - same groups as test1
+ */
+
+#include <iostream>
+#include <fstream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <cstdio>
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+int main() {
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+    const char* tracePath = "/tmp/test21-stats_trace.json";
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    JobOptions options;
+    options.collectStats = true;
+    JobHandle job = startMapReduceJob(client, inputVec, outputVec, 4, options);
+    waitForJob(job);
+    JobStats stats;
+    bool collected = getJobStats(job, &stats);
+    closeJobHandle(job);
+
+    std::sort(outputVec.begin(), outputVec.end(),
+              [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+    for (OutputPair &p : outputVec) {
+        std::cout << "thread 1 out:\t" << static_cast<elements*>(p.second)->num << '\n';
+    }
+    for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+
+    uint64_t emit2 = 0, emit3 = 0, groups = 0, bytes = 0, mapNanos = 0, spans = 0;
+    for (const ThreadStats &thread : stats.threads) {
+        emit2 += thread.emit2Count;
+        emit3 += thread.emit3Count;
+        bytes += thread.intermediateBytes;
+        mapNanos += thread.wallNanos[PHASE_MAP];
+        spans += thread.spans.size();
+        for (int b = 0; b < GROUP_SIZE_BUCKETS; ++b) groups += thread.groupSizeHistogram[b];
+    }
+    std::cout << "stats collected: " << collected << " threads: " << stats.threads.size() << '\n';
+    std::cout << "emit2: " << emit2 << " emit3: " << emit3 << " groups: " << groups << '\n';
+    std::cout << "bytes: " << (bytes == emit2 * sizeof(IntermediatePair))
+              << " timed: " << (mapNanos > 0 && spans > 0) << '\n';
+
+    writeChromeTrace(stats, tracePath);
+    std::ifstream trace(tracePath);
+    std::string head;
+    trace >> head;
+    std::cout << "trace: " << head.substr(0, 15) << '\n';
+    std::remove(tracePath);
+
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
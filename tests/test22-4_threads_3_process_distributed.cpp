@@ -0,0 +1,142 @@
+/**
+ * @brief run 3 processes of 4 threads as one distributed job over localhost, with and without spilling
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class serializer : public IntermediateSerializer {
+public:
+    void serialize(const K2* key, const V2* value, std::string& out) const override {
+        int nums[2] = { static_cast<const elements*>(key)->num,
+                        static_cast<const elements*>(value)->num };
+        out.append(reinterpret_cast<const char*>(nums), sizeof(nums));
+    }
+    IntermediatePair deserialize(const char* data, size_t size) const override {
+        int nums[2];
+        if (size != sizeof(nums)) return IntermediatePair(nullptr, nullptr);
+        std::memcpy(nums, data, sizeof(nums));
+        return IntermediatePair(new elements(nums[0]), new elements(nums[1]));
+    }
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+int main() {
+    unsigned int numOfThreads = 4;
+    int numOfNodes = 3;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    ClusterSpec cluster;
+    int basePort = 20000 + static_cast<int>(getpid() % 10000) * numOfNodes;
+    for (int r = 0; r < numOfNodes; ++r) {
+        cluster.nodes.push_back("127.0.0.1:" + std::to_string(basePort + r));
+    }
+
+    // Ranks 1.. run in child processes and hand their output back over a pipe
+    std::vector<FILE*> results;
+    std::vector<pid_t> children;
+    for (int r = 1; r < numOfNodes && cluster.rank == 0; ++r) {
+        int fds[2];
+        if (pipe(fds) != 0) return 1;
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            results.assign(1, fdopen(fds[1], "w"));
+            cluster.rank = r;
+        } else {
+            close(fds[1]);
+            results.push_back(fdopen(fds[0], "r"));
+            children.push_back(pid);
+        }
+    }
+
+    serializer wireFormat;
+    std::vector<std::vector<int>> counts(2);
+    for (unsigned m = 0; m < 2; ++m) {
+        JobOptions options;
+        options.memoryBudget = m == 0 ? 0 : 20000;
+        options.serializer = &wireFormat;
+        options.cluster = &cluster;
+        JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+        closeJobHandle(job);
+
+        std::sort(outputVec.begin(), outputVec.end(),
+                  [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+        for (OutputPair &p : outputVec) {
+            if (cluster.rank != 0) {
+                std::fprintf(results[0], "%u %d\n", m, static_cast<elements*>(p.second)->num);
+            } else {
+                counts[m].push_back(static_cast<elements*>(p.second)->num);
+            }
+            delete p.first;
+            delete p.second;
+        }
+        outputVec.clear();
+    }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    if (cluster.rank != 0) {
+        std::fclose(results[0]);
+        return 0;
+    }
+
+    // Outputs in rank order cover the keys in order
+    for (size_t i = 0; i < results.size(); ++i) {
+        unsigned m;
+        int count;
+        while (std::fscanf(results[i], "%u %d", &m, &count) == 2) {
+            counts[m].push_back(count);
+        }
+        std::fclose(results[i]);
+        int status;
+        waitpid(children[i], &status, 0);
+    }
+    for (unsigned m = 0; m < 2; ++m) {
+        for (int count : counts[m]) {
+            std::cout << "thread " << m+1 << " out:\t" << count << '\n';
+        }
+    }
+    return 0;
+}
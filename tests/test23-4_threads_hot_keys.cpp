@@ -0,0 +1,112 @@
+/**
+ * @brief run 4 threads counting distinct values per key where one key holds half the pairs - hot keys are split into combined slices
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <set>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+unsigned int unique_keys = 100;
+unsigned int unique_values = 5000;
+std::atomic<bool> reducing(false);
+std::mutex slice_mutex;
+std::set<void*> slice_threads;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int num = static_cast<const elements*>(key)->num;
+        int input = (num % 2 == 0) ? 0 : 1 + (num / 2) % unique_keys;
+        emit2(new elements(input), new elements(num % unique_values), context);
+    }
+    void combine(const IntermediateVec* pairs, void* context) const override {
+        if (reducing) {
+            // A hot-key slice: note its thread and take long enough for the others to claim theirs
+            {
+                std::lock_guard<std::mutex> lock(slice_mutex);
+                slice_threads.insert(context);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        for (int value : distinct(pairs)) {
+            emit2(new elements(key), new elements(value), context);
+        }
+    }
+    bool hasCombiner() const override { return true; }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        int count = static_cast<int>(distinct(pairs).size());
+        emit3(new elements(key), new elements(count), context);
+    }
+private:
+    // Collects the distinct values of a group and releases its pairs
+    static std::set<int> distinct(const IntermediateVec* pairs) {
+        std::set<int> values;
+        for (const IntermediatePair& pair : *pairs) {
+            values.insert(static_cast<const elements*>(pair.second)->num);
+            delete pair.first;
+            delete pair.second;
+        }
+        return values;
+    }
+};
+
+void onStage(JobHandle, stage_t stage, void*) {
+    reducing = stage == REDUCE_STAGE;
+}
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    bool splitHot[] = { false, true };
+    for (unsigned m = 0; m < 2; ++m) {
+        JobOptions options;
+        options.splitHotKeys = splitHot[m];
+        options.collectStats = true;
+        options.onStage = onStage;
+        slice_threads.clear();
+        JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+        waitForJob(job);
+        JobStats stats;
+        getJobStats(job, &stats);
+        closeJobHandle(job);
+
+        std::sort(outputVec.begin(), outputVec.end(),
+                  [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+        for (OutputPair &p : outputVec) {
+            std::cout << "thread " << m+1 << " out:\t" << static_cast<elements*>(p.second)->num << '\n';
+        }
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+        outputVec.clear();
+        std::cout << "thread " << m+1 << " groups: " << stats.skew.groups
+                  << " hot keys: " << stats.skew.hotKeys
+                  << " largest is hot: " << (stats.skew.hotKeyPairs == stats.skew.largestGroupPairs)
+                  << " slices on several threads: " << (slice_threads.size() > 1) << '\n';
+    }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @brief run 4 threads with a client that reduces groups in place through reduceSpan, serial and pipelined parallel
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <atomic>
+
+unsigned int unique_keys = 100;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+std::atomic<int> vector_reduces(0);
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        vector_reduces++;
+        reduceSpan(pairs->data(), pairs->size(), context);
+    }
+    void reduceSpan(const IntermediatePair* pairs, size_t count, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs[0].first)->num),
+                new elements(static_cast<int>(count)),
+                context
+        );
+        for (size_t i = 0; i < count; ++i) {
+            delete pairs[i].first;
+            delete pairs[i].second;
+        }
+    }
+    bool hasSpanReduce() const override { return true; }
+};
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    shuffle_mode_t modes[] = { SHUFFLE_SERIAL, SHUFFLE_PARALLEL };
+    bool pipelined[] = { false, true };
+    for (unsigned m = 0; m < 2; ++m) {
+        JobOptions options;
+        options.shuffleMode = modes[m];
+        options.pipelineReduce = pipelined[m];
+        JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+        closeJobHandle(job);
+
+        std::sort(outputVec.begin(), outputVec.end(),
+                  [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+        for (OutputPair &p : outputVec) {
+            std::cout << "thread " << m+1 << " out:\t" << static_cast<elements*>(p.second)->num << '\n';
+        }
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+        outputVec.clear();
+    }
+    std::cout << "vector reduces: " << vector_reduces << '\n';
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * @brief run 4 threads three times through a map cache - unchanged partitions reuse their cached runs
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+
+unsigned int unique_keys = 100;
+unsigned int partition_chunks = 10000;
+std::atomic<int> map_calls(0);
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class serializer : public IntermediateSerializer {
+public:
+    void serialize(const K2* key, const V2* value, std::string& out) const override {
+        int nums[2] = { static_cast<const elements*>(key)->num,
+                        static_cast<const elements*>(value)->num };
+        out.append(reinterpret_cast<const char*>(nums), sizeof(nums));
+    }
+    IntermediatePair deserialize(const char* data, size_t size) const override {
+        int nums[2];
+        if (size != sizeof(nums)) return IntermediatePair(nullptr, nullptr);
+        std::memcpy(nums, data, sizeof(nums));
+        return IntermediatePair(new elements(nums[0]), new elements(nums[1]));
+    }
+};
+
+// The version of each partition stands in for a hash of its contents
+uint64_t fingerprint(size_t firstChunk, size_t chunkCount, void* userData) {
+    return (*static_cast<std::vector<uint64_t>*>(userData))[firstChunk / partition_chunks];
+}
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        map_calls++;
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+// Runs one job and returns its counts in key order
+std::vector<int> run(const tester& client, const InputVec& inputVec, const JobOptions& options) {
+    OutputVec outputVec;
+    JobHandle job = startMapReduceJob(client, inputVec, outputVec, 4, options);
+    closeJobHandle(job);
+    std::sort(outputVec.begin(), outputVec.end(),
+              [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+    std::vector<int> counts;
+    for (OutputPair &p : outputVec) {
+        counts.push_back(static_cast<elements*>(p.second)->num);
+        delete p.first;
+        delete p.second;
+    }
+    return counts;
+}
+
+int main() {
+    InputVec inputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    serializer cacheFormat;
+    MapCache cache(partition_chunks);
+    std::vector<uint64_t> versions(inputVec.size() / partition_chunks, 1);
+    JobOptions options;
+    options.serializer = &cacheFormat;
+    options.mapCache = &cache;
+    options.partitionFingerprint = fingerprint;
+    options.callbackData = &versions;
+
+    for (unsigned m = 0; m < 2; ++m) {
+        for (int count : run(client, inputVec, options)) {
+            std::cout << "thread " << m+1 << " out:\t" << count << '\n';
+        }
+        std::cout << "thread " << m+1 << " mapped: " << cache.mappedPartitions()
+                  << " reused: " << cache.reusedPartitions() << '\n';
+    }
+
+    // Change one partition: only it is mapped again
+    for (size_t j = 3 * partition_chunks; j < 4 * partition_chunks; ++j) {
+        static_cast<elements*>(inputVec[j].first)->num = static_cast<int>(j % 7);
+    }
+    versions[3]++;
+    map_calls = 0;
+    std::vector<int> incremental = run(client, inputVec, options);
+    std::cout << "incremental mapped: " << cache.mappedPartitions()
+              << " reused: " << cache.reusedPartitions() << " map calls: " << map_calls << '\n';
+    std::vector<int> fresh = run(client, inputVec, JobOptions());
+    std::cout << "matches fresh job: " << (incremental == fresh) << '\n';
+
+    // Cached jobs fall back to the serial shuffle, pipelined or not
+    versions[5]++;
+    JobOptions pipelined = options;
+    pipelined.shuffleMode = SHUFFLE_PARALLEL;
+    pipelined.pipelineReduce = true;
+    std::vector<int> overlapped = run(client, inputVec, pipelined);
+    std::cout << "parallel pipelined mapped: " << cache.mappedPartitions()
+              << " reused: " << cache.reusedPartitions()
+              << " matches fresh job: " << (overlapped == fresh) << '\n';
+
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * @brief run 4 threads emitting inline pairs - counts match test7 with no intermediate objects
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <atomic>
+
+unsigned int unique_keys = 100;
+std::atomic<int> constructed(0);
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; ++constructed; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        unsigned input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emitInline(input, 1, context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override { }
+    void reduceInline(const InlinePair* pairs, size_t count, void* context) const override {
+        InlineSpan<unsigned, int> group(pairs, count);
+        int total = 0;
+        for (size_t i = 0; i < group.size(); ++i) {
+            total += group.value(i);
+        }
+        emit3(new elements(group.key()), new elements(total), context);
+    }
+};
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    JobOptions options;
+    options.inlinePairs = true;
+    options.shuffleMode = SHUFFLE_PARALLEL; // Ignored: inline jobs shuffle serially
+    constructed = 0;
+    JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+    closeJobHandle(job);
+
+    std::sort(outputVec.begin(), outputVec.end(),
+              [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+    for (OutputPair &p : outputVec) {
+        std::cout << "thread 1 out:\t" << static_cast<elements*>(p.second)->num << '\n';
+    }
+    std::cout << "objects beyond output: " << constructed - 2 * static_cast<int>(outputVec.size()) << '\n';
+    for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
@@ -0,0 +1,202 @@
+/**
+ * @brief run 4 threads and cancel jobs in map, in reduce and by deadline - every pair is released
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+unsigned int unique_keys = 100;
+std::atomic<int> live(0);
+std::atomic<int> map_calls(0);
+std::atomic<int> reduce_calls(0);
+std::atomic<int> discarded(0);
+int cancel_after_maps = -1;
+int cancel_after_reduces = -1;
+bool slow_map = false;
+int slow_map_micros = 100;
+JobHandle current = nullptr;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; ++live; }
+    ~elements() { --live; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+size_t hashElement(const K2* key) {
+    return static_cast<size_t>(static_cast<const elements*>(key)->num);
+}
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        if (++map_calls == cancel_after_maps) cancelJob(current);
+        if (slow_map) std::this_thread::sleep_for(std::chrono::microseconds(slow_map_micros));
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void combine(const IntermediateVec* pairs, void* context) const override {
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        int count = sum(pairs->data(), pairs->size());
+        emit2(new elements(key), new elements(count), context);
+    }
+    bool hasCombiner() const override { return true; }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        if (++reduce_calls == cancel_after_reduces) cancelJob(current);
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        int count = sum(pairs->data(), pairs->size());
+        emit3(new elements(key), new elements(count), context);
+    }
+    void discard(const IntermediatePair* pairs, size_t count, void* context) const override {
+        discarded += static_cast<int>(count);
+        sum(pairs, count);
+    }
+private:
+    // Sums the counts of a group and releases its pairs
+    static int sum(const IntermediatePair* pairs, size_t count) {
+        int total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            total += static_cast<const elements*>(pairs[i].second)->num;
+            delete pairs[i].first;
+            delete pairs[i].second;
+        }
+        return total;
+    }
+};
+
+// Relies on the default discard, which deletes the pairs
+class plainTester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        if (++map_calls == cancel_after_maps) cancelJob(current);
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        if (++reduce_calls == cancel_after_reduces) cancelJob(current);
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+        emit3(new elements(key), new elements(static_cast<int>(pairs->size())), context);
+    }
+};
+
+void onStage(JobHandle job, stage_t stage, void*) {
+    if (stage == MAP_STAGE) current = job;
+}
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+    const int inputObjects = live;
+
+    const char* names[] = { "serial", "parallel", "pipelined", "hash", "split" };
+    for (int phase = 0; phase < 3; ++phase) {
+        for (int m = 0; m < 5; ++m) {
+            JobOptions options;
+            options.onStage = onStage;
+            options.shuffleMode = m == 1 ? SHUFFLE_PARALLEL : m == 3 ? SHUFFLE_HASH : SHUFFLE_SERIAL;
+            options.pipelineReduce = m == 2;
+            options.keyHash = hashElement;
+            options.splitGroupPairs = m == 4 ? 64 : 0;
+            map_calls = 0;
+            reduce_calls = 0;
+            discarded = 0;
+            cancel_after_maps = phase == 0 ? 20000 : -1;
+            cancel_after_reduces = phase == 1 ? 10 : -1;
+            slow_map = phase == 2;
+            if (phase == 2) options.deadlineMillis = 20;
+
+            JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+            waitForJob(job);
+            bool cancelled = isJobCancelled(job);
+            closeJobHandle(job);
+
+            bool mappedPart = map_calls < 50000;
+            bool reducedPart = phase != 1 || (reduce_calls < 100 && discarded > 0);
+            for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+            outputVec.clear();
+            std::cout << "cancel " << (phase == 0 ? "in map" : phase == 1 ? "in reduce" : "by deadline")
+                      << " (" << names[m] << "): cancelled " << cancelled
+                      << " stopped early " << (phase == 1 ? reducedPart : mappedPart)
+                      << " leaked " << (live - inputObjects) << '\n';
+        }
+    }
+
+    plainTester plainClient;
+    for (int phase = 0; phase < 2; ++phase) {
+        JobOptions options;
+        options.onStage = onStage;
+        map_calls = 0;
+        reduce_calls = 0;
+        cancel_after_maps = phase == 0 ? 20000 : -1;
+        cancel_after_reduces = phase == 1 ? 10 : -1;
+        slow_map = false;
+        JobHandle job = startMapReduceJob(plainClient, inputVec, outputVec, numOfThreads, options);
+        closeJobHandle(job);
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+        outputVec.clear();
+        std::cout << "default discard " << (phase == 0 ? "in map" : "in reduce")
+                  << ": leaked " << (live - inputObjects) << '\n';
+    }
+
+    // Cancelled while autoThreads is still timing its probe chunks
+    JobOptions probeOptions;
+    probeOptions.onStage = onStage;
+    probeOptions.autoThreads = true;
+    map_calls = 0;
+    cancel_after_maps = 10;
+    cancel_after_reduces = -1;
+    JobHandle probeJob = startMapReduceJob(client, inputVec, outputVec, numOfThreads, probeOptions);
+    waitForJob(probeJob);
+    std::cout << "cancel in auto probe: cancelled " << isJobCancelled(probeJob)
+              << " maps after cancel " << (map_calls - cancel_after_maps)
+              << " leaked " << (live - inputObjects) << '\n';
+    closeJobHandle(probeJob);
+    for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+    outputVec.clear();
+    cancel_after_maps = -1;
+
+    // The deadline passes while the probe maps its first (slow) chunks
+    probeOptions.deadlineMillis = 20;
+    map_calls = 0;
+    slow_map = true;
+    slow_map_micros = 2000;
+    probeJob = startMapReduceJob(client, inputVec, outputVec, numOfThreads, probeOptions);
+    waitForJob(probeJob);
+    std::cout << "deadline in auto probe: cancelled " << isJobCancelled(probeJob)
+              << " stopped within the probe " << (map_calls < 64)
+              << " leaked " << (live - inputObjects) << '\n';
+    closeJobHandle(probeJob);
+    for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+    outputVec.clear();
+    slow_map = false;
+    slow_map_micros = 100;
+
+    discarded = 0;
+    JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads);
+    waitForJob(job);
+    std::cout << "uncancelled: cancelled " << isJobCancelled(job) << " outputs " << outputVec.size()
+              << " discarded " << discarded << '\n';
+    closeJobHandle(job);
+    for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @brief run 4 threads keeping the 10 largest counts - top of test7 in every shuffle mode
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <atomic>
+
+unsigned int unique_keys = 100;
+std::atomic<int> live(0);
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; ++live; }
+    ~elements() { --live; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+        emit3(new elements(key), new elements(static_cast<int>(pairs->size())), context);
+    }
+};
+
+// Ranks by count, then by key so that ties are deterministic
+bool countLess(const OutputPair& a, const OutputPair& b) {
+    int countA = static_cast<const elements*>(a.second)->num;
+    int countB = static_cast<const elements*>(b.second)->num;
+    if (countA != countB) return countA < countB;
+    return *a.first < *b.first;
+}
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+    const int inputObjects = live;
+
+    shuffle_mode_t modes[] = { SHUFFLE_SERIAL, SHUFFLE_PARALLEL, SHUFFLE_SERIAL };
+    bool pipelined[] = { false, false, true };
+    for (unsigned m = 0; m < 3; ++m) {
+        JobOptions options;
+        options.shuffleMode = modes[m];
+        options.pipelineReduce = pipelined[m];
+        options.topK = 10;
+        options.outputLess = countLess;
+        JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+        closeJobHandle(job);
+
+        for (OutputPair &p : outputVec) {
+            std::cout << "thread " << m+1 << " out:\t" << static_cast<elements*>(p.first)->num
+                      << '\t' << static_cast<elements*>(p.second)->num << '\n';
+        }
+        std::cout << "kept objects: " << (live - inputObjects) << '\n';
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+        outputVec.clear();
+    }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
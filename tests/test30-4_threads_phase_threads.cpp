@@ -0,0 +1,110 @@
+/**
+ * @brief run 4 threads with fewer map and reduce threads, fixed and automatic - counts match test7
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+unsigned int unique_keys = 100;
+bool slow_map = false;
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        if (slow_map) std::this_thread::sleep_for(std::chrono::microseconds(50));
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        int key = static_cast<const elements*>(pairs->at(0).first)->num;
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+        emit3(new elements(key), new elements(static_cast<int>(pairs->size())), context);
+    }
+};
+
+// Counts the threads that emitted pairs in map and in reduce
+void printWorkers(const char* name, const JobStats& stats) {
+    int mappers = 0;
+    int reducers = 0;
+    for (const ThreadStats& thread : stats.threads) {
+        mappers += thread.emit2Count > 0;
+        reducers += thread.emit3Count > 0;
+    }
+    std::cout << name << ": map threads " << stats.mapThreads << " (" << mappers << " emitted)"
+              << " reduce threads " << stats.reduceThreads << " (" << reducers << " emitted)\n";
+}
+
+int main() {
+    unsigned int numOfThreads = 4;
+    InputVec inputVec;
+    OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    // Fixed phase sizes: two mappers and one reducer, in each shuffle mode
+    shuffle_mode_t modes[] = { SHUFFLE_SERIAL, SHUFFLE_PARALLEL, SHUFFLE_SERIAL };
+    bool pipelined[] = { false, false, true };
+    for (unsigned m = 0; m < 3; ++m) {
+        JobOptions options;
+        options.shuffleMode = modes[m];
+        options.pipelineReduce = pipelined[m];
+        options.mapThreads = 2;
+        options.reduceThreads = 1;
+        options.collectStats = true;
+        JobHandle job = startMapReduceJob(client, inputVec, outputVec, numOfThreads, options);
+        waitForJob(job);
+        JobStats stats;
+        getJobStats(job, &stats);
+        closeJobHandle(job);
+
+        std::sort(outputVec.begin(), outputVec.end(),
+                  [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+        for (OutputPair &p : outputVec) {
+            std::cout << "thread " << m+1 << " out:\t" << static_cast<elements*>(p.second)->num << '\n';
+        }
+        printWorkers("fixed", stats);
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+        outputVec.clear();
+    }
+
+    // Automatic sizing: a cheap small job stays on one thread, a slow map spreads out
+    InputVec smallInput(inputVec.begin(), inputVec.begin() + 1000);
+    InputVec slowInput(inputVec.begin(), inputVec.begin() + 4000);
+    for (int slow = 0; slow < 2; ++slow) {
+        slow_map = slow == 1;
+        JobOptions options;
+        options.autoThreads = true;
+        options.collectStats = true;
+        JobHandle job = startMapReduceJob(client, slow_map ? slowInput : smallInput, outputVec,
+                                          numOfThreads, options);
+        waitForJob(job);
+        JobStats stats;
+        getJobStats(job, &stats);
+        closeJobHandle(job);
+        printWorkers(slow_map ? "auto slow map" : "auto small", stats);
+        for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+        outputVec.clear();
+    }
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
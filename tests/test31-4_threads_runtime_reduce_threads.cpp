@@ -0,0 +1,81 @@
+/**
+ * @brief run pipelined 4 thread runtime jobs reduced by 1 thread - same counts as test7, nothing leaked
+ */
+
+#include <iostream>
+#include "MapReduceClient.h"
+#include "MapReduceFramework.h"
+#include <algorithm>
+#include <atomic>
+
+unsigned int unique_keys = 100;
+std::atomic<int> live(0);
+
+class elements : public K1, public K2, public K3, public V1, public V2, public V3 {
+public:
+    elements(int i) { num = i; ++live; }
+    ~elements() { --live; }
+    bool operator<(const K1 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K2 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    bool operator<(const K3 &other) const { return num < dynamic_cast<const elements&>(other).num; }
+    int num;
+};
+
+class tester : public MapReduceClient {
+public:
+    void map(const K1* key, const V1* val, void* context) const override {
+        int input = (static_cast<const elements*>(key)->num) % unique_keys;
+        emit2(new elements(input), new elements(1), context);
+    }
+    void reduce(const IntermediateVec* pairs, void* context) const override {
+        emit3(
+                new elements(static_cast<const elements*>(pairs->at(0).first)->num),
+                new elements(static_cast<int>(pairs->size())),
+                context
+        );
+        for (const IntermediatePair& pair : *pairs) {
+            delete pair.first;
+            delete pair.second;
+        }
+    }
+};
+
+int main() {
+    InputVec inputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.push_back({ new elements(std::rand()), nullptr });
+    }
+
+    const int inputObjects = live;
+
+    // Left-out threads must not recycle their runs while thread 0 still merges them
+    RuntimeHandle runtime = createRuntime(4);
+    shuffle_mode_t modes[] = { SHUFFLE_SERIAL, SHUFFLE_PARALLEL };
+    for (int round = 0; round < 2; ++round) {
+        for (int m = 0; m < 2; ++m) {
+            OutputVec outputVec;
+            JobOptions options;
+            options.shuffleMode = modes[m];
+            options.pipelineReduce = true;
+            options.reduceThreads = 1;
+            JobHandle job = startMapReduceJob(runtime, client, inputVec, outputVec, 4, options);
+            closeJobHandle(job);
+
+            std::sort(outputVec.begin(), outputVec.end(),
+                      [](const OutputPair &a, const OutputPair &b) { return *a.first < *b.first; });
+            if (round == 0) {
+                for (OutputPair &p : outputVec) {
+                    std::cout << "thread " << m+1 << " out:\t" << static_cast<elements*>(p.second)->num << '\n';
+                }
+            }
+            for (OutputPair &p : outputVec) { delete p.first; delete p.second; }
+            std::cout << "round " << round + 1 << " leaked: " << (live - inputObjects) << '\n';
+        }
+    }
+    closeRuntime(runtime);
+    for (InputPair &p : inputVec) { delete p.first; delete p.second; }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/**
+ * @brief run 4 threads through the typed MapReduceJob - same counts as test1
+ */
+
+#include <iostream>
+#include "MapReduceJob.h"
+#include <algorithm>
+#include <cstdlib>
+
+unsigned int unique_keys = 100;
+
+class tester;
+typedef MapReduceJob<int, int, int, int, int, int, tester> Job;
+
+class tester {
+public:
+    void map(const int& key, const int& /*val*/, Job::MapContext& context) const {
+        context.emit(static_cast<int>(key % unique_keys), 1);
+    }
+    void reduce(const int& key, const int* values, size_t count, Job::ReduceContext& context) const {
+        int total = 0;
+        for (size_t i = 0; i < count; ++i) total += values[i];
+        context.emit(key, total);
+    }
+};
+
+int main() {
+    Job::InputVec inputVec;
+    Job::OutputVec outputVec;
+    tester client;
+
+    std::srand(0);
+    for (int j = 0; j < 100000; ++j) {
+        inputVec.emplace_back(std::rand(), 0);
+    }
+
+    {
+        Job job(client, inputVec, outputVec, 4);
+        job.wait();
+        JobState state;
+        job.getJobState(&state);
+        if (state.stage != REDUCE_STAGE || state.percentage != 100.0f) {
+            std::cout << "unexpected final state\n";
+        }
+    }
+
+    std::sort(outputVec.begin(), outputVec.end());
+    for (const std::pair<int, int> &p : outputVec) {
+        std::cout << "thread 1 out:\t" << p.second << '\n';
+    }
+    return 0;
+}